@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2024 Xuran Yang
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Skewed access streams for the random read kernels. A distribution gives
+ * every chunk of the working set a popularity rank. Ranks are mapped to
+ * chunks through a random permutation, so the hot chunks are scattered over
+ * the working set. The stream is an array of 32-bit chunk indexes, which
+ * RandomReaderIndex turns into addresses.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "access-stream.h"
+
+char *access_dist_name[] = { "Uniform", "Zipf", "Hot/Cold", "Scan Mix", 0 };
+
+/* Ranks [start, start + count) that share the per-rank probability p. */
+struct rank_class {
+	unsigned long start, count;
+	double p;
+};
+
+#define MAX_CLASSES 4096
+
+static uint64_t next_random(uint64_t *state)
+{
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+static double next_double(uint64_t *state)
+{
+	return (next_random(state) >> 11) * 0x1p-53;
+}
+
+/*
+ * Split @n ranks into classes of (nearly) equal probability. Zipf ranks below
+ * 1024 get a class each, above that a class spans 1/256 of its start rank,
+ * so the probability inside one class varies by less than 0.4%. The scan mix
+ * uses uniform ranks for its random part. Returns the number of classes.
+ */
+static int build_classes(int dist, const struct access_param *ap, unsigned long n,
+			 struct rank_class *cls)
+{
+	unsigned long hot = n * ap->hot_set;
+	double zeta = 0;
+	int c = 0;
+
+	if (dist == DIST_ZIPF) {
+		for (unsigned long r = 0; r < n; c++) {
+			unsigned long w = r < 1024 ? 1 : r / 256;
+
+			if (w > n - r)
+				w = n - r;
+			cls[c].start = r;
+			cls[c].count = w;
+			cls[c].p = 0;
+			for (unsigned long i = r; i < r + w; i++)
+				cls[c].p += pow(i + 1, -ap->theta);
+			zeta += cls[c].p;
+			cls[c].p /= w;
+			r += w;
+		}
+		for (int i = 0; i < c; i++)
+			cls[i].p /= zeta;
+		return c;
+	}
+
+	if (dist == DIST_HOTCOLD && hot > 0 && hot < n) {
+		cls[0] = (struct rank_class){ 0, hot, ap->hot_access / hot };
+		cls[1] = (struct rank_class){ hot, n - hot, (1 - ap->hot_access) / (n - hot) };
+		return 2;
+	}
+
+	cls[0] = (struct rank_class){ 0, n, 1.0 / n };
+	return 1;
+}
+
+/*
+ * Fill @stream with @len chunk indexes drawn from @dist over @n chunks. Ranks
+ * are mapped to chunks by a permutation drawn from @seed, the sequential part
+ * of the scan mix walks the chunks in address order. Runs outside the timed
+ * region.
+ */
+void access_stream(int dist, const struct access_param *ap, unsigned long n, uint32_t *stream,
+		   unsigned long len, uint64_t seed)
+{
+	struct rank_class *cls = malloc(MAX_CLASSES * sizeof(*cls));
+	double *cum = malloc(MAX_CLASSES * sizeof(*cum));
+	uint32_t *ranked = malloc(n * sizeof(*ranked));
+	uint64_t state = seed;
+	unsigned long cursor = next_random(&state) % n;
+	int c = build_classes(dist, ap, n, cls);
+
+	for (unsigned long i = 0; i < n; i++)
+		ranked[i] = i;
+	for (unsigned long i = n - 1; i > 0; i--) {
+		unsigned long j = next_random(&state) % (i + 1);
+		uint32_t t = ranked[i];
+
+		ranked[i] = ranked[j];
+		ranked[j] = t;
+	}
+
+	for (int i = 0; i < c; i++)
+		cum[i] = (i ? cum[i - 1] : 0) + cls[i].p * cls[i].count;
+
+	for (unsigned long i = 0; i < len; i++) {
+		int lo = 0, hi = c - 1;
+		double u;
+
+		if (dist == DIST_SCAN && next_double(&state) < ap->scan) {
+			stream[i] = cursor;
+			cursor = cursor + 1 == n ? 0 : cursor + 1;
+			continue;
+		}
+		u = next_double(&state) * cum[c - 1];
+		while (lo < hi) {
+			int mid = (lo + hi) / 2;
+
+			if (cum[mid] > u)
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		stream[i] = ranked[cls[lo].start + next_random(&state) % cls[lo].count];
+	}
+
+	free(ranked);
+	free(cls);
+	free(cum);
+}
+
+/*
+ * Probability that a chunk with per-reference probability @p among the
+ * random references is cached after @t references, when a share @scan of
+ * the references walks the @n chunks sequentially. The walk touched the
+ * chunk within the last @t references with probability scan * t / n.
+ */
+static double cached(double p, double scan, double t, unsigned long n)
+{
+	double seen = fmin(1, scan * t / n), x = (1 - scan) * p * t;
+
+	return -expm1(-x) + seen * exp(-x);
+}
+
+static double cache_fill(const struct rank_class *cls, int c, double scan, double t,
+			 unsigned long n)
+{
+	double fill = 0;
+
+	for (int i = 0; i < c; i++)
+		fill += cls[i].count * cached(cls[i].p, scan, t, n);
+	return fill;
+}
+
+/*
+ * Estimated LRU hit rate of @dist over @n chunks in a cache holding
+ * @capacity chunks, using the Che approximation: every chunk stays cached
+ * for a characteristic time T after its last access, where T is chosen so
+ * that the expected number of cached chunks equals the capacity. In the
+ * scan mix both parts fill the cache. A random reference hits if either part
+ * touched its chunk within T. A sequential reference returns to its chunk
+ * only after n / scan references, so below full capacity it hits only if a
+ * random reference touched the chunk within T.
+ */
+double access_hit_rate(int dist, const struct access_param *ap, unsigned long n, double capacity)
+{
+	struct rank_class *cls;
+	double scan = dist == DIST_SCAN ? ap->scan : 0;
+	double lo = 0, hi = capacity, hit = 0, reachable = 0;
+	int c;
+
+	if (capacity >= n)
+		return 1;
+
+	cls = malloc(MAX_CLASSES * sizeof(*cls));
+	c = build_classes(dist, ap, n, cls);
+
+	/*
+	 * Chunks that are never accessed (p = 0, e.g. a cold set without
+	 * accesses or Zipf ranks whose weight underflows) never fill the cache,
+	 * if the rest fits every access hits.
+	 */
+	for (int i = 0; i < c; i++)
+		if (cls[i].p > 0 || scan > 0)
+			reachable += cls[i].count;
+	if (reachable <= capacity) {
+		free(cls);
+		return 1;
+	}
+
+	while (cache_fill(cls, c, scan, hi, n) < capacity) {
+		lo = hi;
+		hi *= 2;
+	}
+	for (int iter = 0; iter < 64; iter++) {
+		double t = (lo + hi) / 2;
+
+		if (cache_fill(cls, c, scan, t, n) < capacity)
+			lo = t;
+		else
+			hi = t;
+	}
+	for (int i = 0; i < c; i++) {
+		double random = -expm1(-(1 - scan) * cls[i].p * lo);
+
+		hit += cls[i].count * cls[i].p * (1 - scan) * cached(cls[i].p, scan, lo, n);
+		hit += cls[i].count * scan / n * random;
+	}
+
+	free(cls);
+	return hit;
+}
+
+static int count_cpus(const char *list)
+{
+	int n = 0, a, b, len;
+
+	while (sscanf(list, "%d%n", &a, &len) == 1) {
+		list += len;
+		b = a;
+		if (*list == '-' && sscanf(list + 1, "%d%n", &b, &len) == 1)
+			list += len + 1;
+		n += b - a + 1;
+		if (*list != ',')
+			break;
+		list++;
+	}
+	return n;
+}
+
+/*
+ * Read the data and unified cache sizes of CPU0 from sysfs. A cache shared by
+ * several CPUs is divided among the threads that can share it. Returns the
+ * number of levels found.
+ */
+int cache_capacities(int threads, int level[], double capacity[], int max)
+{
+	char path[128], buf[256];
+	int n = 0;
+
+	for (int index = 0; n < max; index++) {
+		unsigned long size;
+		char unit = 0;
+		int lvl, shared;
+		FILE *fp;
+
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type",
+			 index);
+		fp = fopen(path, "r");
+		if (fp == NULL)
+			break;
+		if (fgets(buf, sizeof(buf), fp) == NULL)
+			buf[0] = 0;
+		fclose(fp);
+		if (strncmp(buf, "Instruction", 11) == 0)
+			continue;
+
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level",
+			 index);
+		fp = fopen(path, "r");
+		if (fp == NULL || fscanf(fp, "%d", &lvl) != 1)
+			lvl = 0;
+		if (fp)
+			fclose(fp);
+
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size",
+			 index);
+		fp = fopen(path, "r");
+		if (fp == NULL || fscanf(fp, "%lu%c", &size, &unit) < 1)
+			size = 0;
+		if (fp)
+			fclose(fp);
+		if (unit == 'K')
+			size *= 1024;
+		else if (unit == 'M')
+			size *= 1024 * 1024;
+
+		snprintf(path, sizeof(path),
+			 "/sys/devices/system/cpu/cpu0/cache/index%d/shared_cpu_list", index);
+		fp = fopen(path, "r");
+		if (fp == NULL || fgets(buf, sizeof(buf), fp) == NULL)
+			strcpy(buf, "0");
+		if (fp)
+			fclose(fp);
+		shared = count_cpus(buf);
+		if (shared > threads)
+			shared = threads;
+		if (shared < 1)
+			shared = 1;
+
+		if (lvl <= 0 || size == 0)
+			continue;
+		level[n] = lvl;
+		capacity[n] = (double)size / shared;
+		n++;
+	}
+	return n;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2024 Xuran Yang
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACCESS_STREAM_H
+#define ACCESS_STREAM_H
+
+#include <stdint.h>
+
+enum { DIST_UNIFORM = 0, DIST_ZIPF = 1, DIST_HOTCOLD = 2, DIST_SCAN = 3, DIST_MAX };
+
+/* Shape of the skewed distributions, the fractions are in [0, 1]. */
+struct access_param {
+	double theta;
+	double hot_set, hot_access;
+	double scan;
+};
+
+extern char *access_dist_name[];
+
+void access_stream(int dist, const struct access_param *ap, unsigned long n, uint32_t *stream,
+		   unsigned long len, uint64_t seed);
+double access_hit_rate(int dist, const struct access_param *ap, unsigned long n, double capacity);
+int cache_capacities(int threads, int level[], double capacity[], int max);
+
+#endif
@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2024 Xuran Yang
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <omp.h>
+
+#include "fault.h"
+
+#ifndef MADV_COLLAPSE
+#define MADV_COLLAPSE 25
+#endif
+
+static size_t base_page_size;
+static size_t huge_page_size;
+
+size_t fault_huge_page_size()
+{
+	FILE *fp;
+	unsigned long size = 0;
+
+	if (huge_page_size)
+		return huge_page_size;
+
+	fp = fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r");
+	if (fp != NULL) {
+		if (fscanf(fp, "%lu", &size) != 1)
+			size = 0;
+		fclose(fp);
+	}
+	huge_page_size = size ? size : 2 * 1024 * 1024;
+	return huge_page_size;
+}
+
+static long get_minflt()
+{
+	struct rusage usage;
+
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_minflt;
+}
+
+/* Anonymous huge pages of the process in bytes, -1 if smaps is unavailable. */
+static long get_anon_huge()
+{
+	FILE *fp = fopen("/proc/self/smaps_rollup", "r");
+	char line[256];
+	long kb = -1;
+
+	if (fp == NULL)
+		return -1;
+	while (fgets(line, sizeof(line), fp)) {
+		if (sscanf(line, "AnonHugePages: %ld kB", &kb) == 1)
+			break;
+	}
+	fclose(fp);
+	return kb < 0 ? -1 : kb * 1024;
+}
+
+/*
+ * Map an anonymous region aligned to @align, so that with huge page
+ * alignment every PMD range of a huge page multiple lies fully inside it, and
+ * pin the THP policy for the page type.
+ */
+static char *map_region(size_t size, size_t align, int huge)
+{
+	size_t len = size + align;
+	uintptr_t p, a;
+
+	p = (uintptr_t)mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+			    0);
+	if ((void *)p == MAP_FAILED) {
+		perror("mmap");
+		exit(1);
+	}
+	a = (p + align - 1) & ~(align - 1);
+	if (a > p)
+		munmap((void *)p, a - p);
+	if (p + len > a + size)
+		munmap((void *)(a + size), p + len - (a + size));
+
+	madvise((void *)a, size, huge ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+	return (char *)a;
+}
+
+static void touch_region(char *p, size_t size)
+{
+	for (size_t off = 0; off < size; off += base_page_size)
+		*(volatile char *)(p + off) = 1;
+}
+
+static void record(double start, double end, long faults, size_t bytes, double *fault_rate,
+		   double *bandwidth)
+{
+	*fault_rate = faults / (end - start);
+	*bandwidth = (double)bytes / 1024 / 1024 / 1024 / (end - start);
+}
+
+/*
+ * Each of @threads threads owns a private region of @size bytes and repeats
+ * the operation @loops times. Only the kernel work is inside the timed
+ * section: mapping for the first-touch test and populating for the
+ * MADV_DONTNEED and collapse tests happen outside it. Fault counts are the
+ * minor faults the process actually took, so a THP run that silently fell
+ * back to base pages shows up as a high fault rate.
+ */
+void fault_performance_test(int threads, size_t size, int loops, int huge, double fault_rate[],
+			    double bandwidth[])
+{
+	char **regions;
+	double start, end, elapsed;
+	long faults, minflt;
+	size_t bytes = size * threads * loops;
+	size_t align;
+
+	base_page_size = sysconf(_SC_PAGESIZE);
+	fault_huge_page_size();
+	align = huge ? huge_page_size : base_page_size;
+
+	regions = (char **)malloc(threads * sizeof(char *));
+	if (regions == NULL) {
+		fprintf(stderr, "malloc failed\n");
+		exit(1);
+	}
+
+	/* Anonymous first touch into freshly mapped memory. */
+	elapsed = 0;
+	faults = 0;
+	for (int l = 0; l < loops; l++) {
+#pragma omp parallel for schedule(static) num_threads(threads)
+		for (int job = 0; job < threads; job++)
+			regions[job] = map_region(size, align, huge);
+		minflt = get_minflt();
+		start = omp_get_wtime();
+#pragma omp parallel for schedule(static) num_threads(threads)
+		for (int job = 0; job < threads; job++)
+			touch_region(regions[job], size);
+		end = omp_get_wtime();
+		faults += get_minflt() - minflt;
+		elapsed += end - start;
+#pragma omp parallel for schedule(static) num_threads(threads)
+		for (int job = 0; job < threads; job++)
+			munmap(regions[job], size);
+	}
+	record(0, elapsed, faults, bytes, &fault_rate[FAULT_TOUCH], &bandwidth[FAULT_TOUCH]);
+
+	/* Full mmap + touch + munmap cycles, contending on the mm lock. */
+	minflt = get_minflt();
+	start = omp_get_wtime();
+#pragma omp parallel for schedule(static) num_threads(threads)
+	for (int job = 0; job < threads; job++) {
+		for (int l = 0; l < loops; l++) {
+			char *p = map_region(size, align, huge);
+			touch_region(p, size);
+			munmap(p, size);
+		}
+	}
+	end = omp_get_wtime();
+	record(start, end, get_minflt() - minflt, bytes, &fault_rate[FAULT_MMAP],
+	       &bandwidth[FAULT_MMAP]);
+
+	/* Zap populated memory with MADV_DONTNEED and fault it back in. */
+#pragma omp parallel for schedule(static) num_threads(threads)
+	for (int job = 0; job < threads; job++) {
+		regions[job] = map_region(size, align, huge);
+		touch_region(regions[job], size);
+	}
+	minflt = get_minflt();
+	start = omp_get_wtime();
+#pragma omp parallel for schedule(static) num_threads(threads)
+	for (int job = 0; job < threads; job++) {
+		for (int l = 0; l < loops; l++) {
+			madvise(regions[job], size, MADV_DONTNEED);
+			touch_region(regions[job], size);
+		}
+	}
+	end = omp_get_wtime();
+	record(start, end, get_minflt() - minflt, bytes, &fault_rate[FAULT_DONTNEED],
+	       &bandwidth[FAULT_DONTNEED]);
+#pragma omp parallel for schedule(static) num_threads(threads)
+	for (int job = 0; job < threads; job++)
+		munmap(regions[job], size);
+
+	/*
+	 * Synchronous THP collapse of base-page populated memory. The regions
+	 * are huge page aligned, so all of them can collapse. The fault rate
+	 * column reports the huge pages that actually appeared per second.
+	 */
+	fault_rate[FAULT_COLLAPSE] = 0;
+	bandwidth[FAULT_COLLAPSE] = 0;
+	if (huge) {
+		long collapsed = 0, before, after;
+		int failed = 0;
+
+		elapsed = 0;
+		for (int l = 0; l < loops && !failed; l++) {
+#pragma omp parallel for schedule(static) num_threads(threads)
+			for (int job = 0; job < threads; job++) {
+				regions[job] = map_region(size, huge_page_size, 0);
+				touch_region(regions[job], size);
+				madvise(regions[job], size, MADV_HUGEPAGE);
+			}
+			before = get_anon_huge();
+			start = omp_get_wtime();
+#pragma omp parallel for schedule(static) num_threads(threads) reduction(max : failed)
+			for (int job = 0; job < threads; job++) {
+				if (madvise(regions[job], size, MADV_COLLAPSE) != 0)
+					failed = errno;
+			}
+			end = omp_get_wtime();
+			after = get_anon_huge();
+			elapsed += end - start;
+			if (before < 0 || after < 0)
+				collapsed += size * threads / huge_page_size;
+			else if (after > before)
+				collapsed += (after - before) / huge_page_size;
+#pragma omp parallel for schedule(static) num_threads(threads)
+			for (int job = 0; job < threads; job++)
+				munmap(regions[job], size);
+		}
+		if (failed)
+			fprintf(stderr, "MADV_COLLAPSE: %s\n", strerror(failed));
+		else
+			record(0, elapsed, collapsed, collapsed * huge_page_size,
+			       &fault_rate[FAULT_COLLAPSE], &bandwidth[FAULT_COLLAPSE]);
+	}
+
+	printf("Threads = %d, Region = %luKB, %s pages\n", threads, size / 1024,
+	       huge ? "Huge" : "Base");
+	printf("  Touch    : %.0f faults/s, %.2fGB/s\n", fault_rate[FAULT_TOUCH],
+	       bandwidth[FAULT_TOUCH]);
+	printf("  mmap     : %.0f faults/s, %.2fGB/s\n", fault_rate[FAULT_MMAP],
+	       bandwidth[FAULT_MMAP]);
+	printf("  DONTNEED : %.0f faults/s, %.2fGB/s\n", fault_rate[FAULT_DONTNEED],
+	       bandwidth[FAULT_DONTNEED]);
+	if (huge)
+		printf("  Collapse : %.0f pages/s, %.2fGB/s\n", fault_rate[FAULT_COLLAPSE],
+		       bandwidth[FAULT_COLLAPSE]);
+
+	free(regions);
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2024 Xuran Yang
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAULT_H
+#define FAULT_H
+
+#include <stddef.h>
+
+/* Operations measured by fault_performance_test(). */
+enum { FAULT_TOUCH = 0, FAULT_MMAP = 1, FAULT_DONTNEED = 2, FAULT_COLLAPSE = 3, FAULT_MAX };
+
+/* Result lines: base and huge page runs of each operation, collapse is THP only. */
+enum {
+	FAULT_LINE_TOUCH = 0,
+	FAULT_LINE_TOUCH_THP = 1,
+	FAULT_LINE_MMAP = 2,
+	FAULT_LINE_MMAP_THP = 3,
+	FAULT_LINE_DONTNEED = 4,
+	FAULT_LINE_DONTNEED_THP = 5,
+	FAULT_LINE_COLLAPSE_THP = 6,
+	FAULT_LINES
+};
+
+/* Result line of @op for a base (@huge = 0) or huge page run, -1 if none. */
+static inline int fault_line(int op, int huge)
+{
+	static const int lines[FAULT_MAX][2] = {
+		[FAULT_TOUCH] = { FAULT_LINE_TOUCH, FAULT_LINE_TOUCH_THP },
+		[FAULT_MMAP] = { FAULT_LINE_MMAP, FAULT_LINE_MMAP_THP },
+		[FAULT_DONTNEED] = { FAULT_LINE_DONTNEED, FAULT_LINE_DONTNEED_THP },
+		[FAULT_COLLAPSE] = { -1, FAULT_LINE_COLLAPSE_THP },
+	};
+
+	return lines[op][huge != 0];
+}
+
+size_t fault_huge_page_size();
+void fault_performance_test(int threads, size_t size, int loops, int huge, double fault_rate[],
+			    double bandwidth[]);
+
+#endif
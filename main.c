@@ -26,8 +26,20 @@
 #include <omp.h>
 #include <time.h>
 #include <sys/utsname.h>
+#include <sys/auxv.h>
 #include <math.h>
 
+#include "fault.h"
+#include "string-routines.h"
+#include "access-stream.h"
+
+#ifndef HWCAP_SVE
+#define HWCAP_SVE	(1 << 22)
+#endif
+#ifndef HWCAP2_SVE2
+#define HWCAP2_SVE2	(1 << 1)
+#endif
+
 extern void create_plot(const char *filename, const char *title, const char *xlabel,
 			const char *ylabel);
 extern void set_label(int xlabel_s, const char xlabel[][xlabel_s], int xc,
@@ -46,8 +58,29 @@ extern int RandomReaderVector(void *ptr, unsigned long n_chunks, unsigned long l
 extern int WriterVector(void *ptr, unsigned long size, unsigned long loops, unsigned long value);
 extern int RandomWriterVector(void *ptr, unsigned long size, unsigned long loops,
 			      unsigned long value);
+extern int SVEVectorLength();
+extern void memcpy_sve(void *dest, void *src, size_t n);
+extern int ReaderSVE(void *ptr, unsigned long size, unsigned long loops);
+extern int RandomReaderSVE(void *ptr, unsigned long n_chunks, unsigned long loops);
+extern int WriterSVE(void *ptr, unsigned long size, unsigned long loops, unsigned long value);
+extern int RandomWriterSVE(void *ptr, unsigned long size, unsigned long loops,
+			   unsigned long value);
+extern int RandomReaderIndex(void *base, const uint32_t *index, unsigned long len,
+			     unsigned long loops);
+extern int RandomReaderPrefetchL1Keep(void *ptr, unsigned long n_chunks, unsigned long loops,
+				      unsigned long distance);
+extern int RandomReaderPrefetchL2Keep(void *ptr, unsigned long n_chunks, unsigned long loops,
+				      unsigned long distance);
+extern int RandomReaderPrefetchL1Strm(void *ptr, unsigned long n_chunks, unsigned long loops,
+				      unsigned long distance);
+extern int RandomWriterPrefetchL1Keep(void *ptr, unsigned long n_chunks, unsigned long loops,
+				      unsigned long value, unsigned long distance);
+extern int RandomWriterPrefetchL2Keep(void *ptr, unsigned long n_chunks, unsigned long loops,
+				      unsigned long value, unsigned long distance);
+extern int RandomWriterPrefetchL1Strm(void *ptr, unsigned long n_chunks, unsigned long loops,
+				      unsigned long value, unsigned long distance);
 void float_matrix_performance_test(int N, double *f64_s_t, double *f64_v_t, double *f32_s_t,
-				   double *f32_v_t);
+				   double *f32_v_t, int use_sve);
 
 #define __MAX_ITER	1000000
 #define MIN_BLOCK_SIZE	256
@@ -62,11 +95,49 @@ enum {
 	PTYPE_MAX
 };
 
-char *test_name[] = { "memcpy", "bandwidth", "matrix", 0 };
-enum { TEST_MEMCPY = 0, TEST_BANDWIDTH = 1, TEST_MATRIX = 2, TEST_MAX };
+/* Buffer size of the string alignment and match position sweeps. */
+#define STR_SWEEP_SIZE	4096
+#define STR_MAX_OFFSET	64
+
+enum { PF_L1KEEP = 0, PF_L2KEEP = 1, PF_L1STRM = 2, PF_MAX };
+/* Reads prefetch with PLD*, writes with the matching PST* type. */
+char *prefetch_type_name[2][PF_MAX] = {
+	{ "pldl1keep", "pldl2keep", "pldl1strm" },
+	{ "pstl1keep", "pstl2keep", "pstl1strm" },
+};
+static int (*prefetch_readers[PF_MAX])(void *ptr, unsigned long n_chunks, unsigned long loops,
+				       unsigned long distance) = {
+	RandomReaderPrefetchL1Keep,
+	RandomReaderPrefetchL2Keep,
+	RandomReaderPrefetchL1Strm,
+};
+static int (*prefetch_writers[PF_MAX])(void *ptr, unsigned long n_chunks, unsigned long loops,
+				       unsigned long value, unsigned long distance) = {
+	RandomWriterPrefetchL1Keep,
+	RandomWriterPrefetchL2Keep,
+	RandomWriterPrefetchL1Strm,
+};
+/* Prefetch distances in chunks, the kernels wrap them modulo the chunk count. */
+static int prefetch_distance[] = { 0, 1, 2, 4, 8, 16, 32, 64 };
+#define PF_DISTANCES	8
+
+/* Skew stream length in 32-bit chunk indexes. */
+#define STREAM_MIN_LEN	256
+
+char *test_name[] = { "memcpy", "bandwidth", "matrix", "fault", "string", "prefetch", "skew", 0 };
+enum {
+	TEST_MEMCPY = 0,
+	TEST_BANDWIDTH = 1,
+	TEST_MATRIX = 2,
+	TEST_FAULT = 3,
+	TEST_STRING = 4,
+	TEST_PREFETCH = 5,
+	TEST_SKEW = 6,
+	TEST_MAX
+};
 
 char xlabel[128][XLABEL_STR_SIZE];
-double ypoint[4][128];
+double ypoint[8][128];
 
 static int cache_sizes[] = {
 	256,
@@ -135,12 +206,12 @@ inline double get_time()
 	return omp_get_wtime();
 }
 
-void shuffle_array(unsigned long array[], int size)
+void shuffle_array(unsigned long **array, unsigned long size)
 {
-	for (int i = size - 1; i > 0; i--) {
-		int j = (int)(random() % (i + 1));
-		int temp = array[i];
-		array[i] = array[j];
+	for (unsigned long i = size; i > 1; i--) {
+		unsigned long j = random() % i;
+		unsigned long *temp = array[i - 1];
+		array[i - 1] = array[j];
 		array[j] = temp;
 	}
 }
@@ -156,28 +227,261 @@ void format_flot(char *buf, size_t size, double value, char *flag)
 		snprintf(buf, size, "%.0f%s", value, flag);
 }
 
+void format_size(char *buf, size_t n, size_t size)
+{
+	if (size >= 1024 * 1024)
+		format_flot(buf, n, (double)size / 1024 / 1024, "MB");
+	else if (size >= 1024)
+		format_flot(buf, n, (double)size / 1024, "KB");
+	else
+		snprintf(buf, n, "%luB", size);
+}
+
 void caculate_speed(int c, double start, uint64_t iterations, double end, size_t size, int type)
 {
 	double total_time = (end - start);
 	uint64_t single_time = (end - start) * 1e9 / iterations;
 	double *y = &ypoint[type][c];
-	double size_m;
 
 	*y = (double)size * iterations / 1024 / 1024 / ((end - start));
 
-	if (size >= 1024 * 1024) {
-		size_m = (double)size / 1024 / 1024;
-		format_flot(xlabel[c], sizeof(xlabel[c]), size_m, "MB");
-	} else if (size >= 1024) {
-		size_m = (double)size / 1024;
-		format_flot(xlabel[c], sizeof(xlabel[c]), size_m, "KB");
-	} else {
-		snprintf(xlabel[c], sizeof(xlabel[c]), "%luB", size);
-	}
+	format_size(xlabel[c], sizeof(xlabel[c]), size);
 	printf("Size = %s, Speed = %.2fMB/s, Time = %fs, Single Time = %luns, iterations = %lu\n",
 	       xlabel[c], *y, total_time, single_time, iterations);
 }
 
+struct bench_ctx {
+	void *src, *dest;
+	unsigned long **chunk_ptrs;
+	unsigned long n_chunks;
+	uint64_t max_size;
+	uint64_t value;
+	int threads;
+	int test;
+	int dynamic_iter, max_iter;
+	uint64_t iter_bytes;
+	double elapsed;
+	void (*copy)(void *dest, void *src, size_t n);
+	int (*reader)(void *ptr, unsigned long size, unsigned long loops);
+	int (*random_reader)(void *ptr, unsigned long n_chunks, unsigned long loops);
+	int (*writer)(void *ptr, unsigned long size, unsigned long loops, unsigned long value);
+	int (*random_writer)(void *ptr, unsigned long size, unsigned long loops,
+			     unsigned long value);
+};
+
+static struct bench_ctx bench;
+
+/*
+ * Run one kernel of the current test with @size bytes per thread and store
+ * its speed and label in slot @c.
+ */
+void run_kernel(int type, int c, uint64_t size)
+{
+	uint64_t iter = bench.dynamic_iter ? bench.iter_bytes / size : bench.max_iter;
+	uint64_t max_size = bench.max_size;
+	int k = bench.threads;
+	double start, end;
+
+	if (iter == 0)
+		iter = 1;
+	start = get_time();
+	if (bench.test == TEST_MEMCPY) {
+#pragma omp parallel for schedule(static)
+		for (int job = 0; job < k; job++) {
+			for (int i = 0; i < iter; i++) {
+				bench.copy(bench.dest + (max_size / k * job),
+					   (bench.src + (max_size / k) * job), size);
+			}
+		}
+	} else if (type == PTYPE_WRITE) {
+#pragma omp parallel for schedule(static)
+		for (int job = 0; job < k; job++) {
+			bench.writer(bench.src + (max_size / k * job), size, iter, bench.value);
+		}
+	} else if (type == PTYPE_READ) {
+#pragma omp parallel for schedule(static)
+		for (int job = 0; job < k; job++) {
+			bench.reader(bench.src + (max_size / k * job), size, iter);
+		}
+	} else if (type == PTYPE_RANDOM_WRITE) {
+#pragma omp parallel for schedule(static)
+		for (int job = 0; job < k; job++) {
+			bench.random_writer(bench.chunk_ptrs + (bench.n_chunks / k * job),
+					    size / 256, iter, bench.value);
+		}
+	} else if (type == PTYPE_RANDOM_READ) {
+#pragma omp parallel for schedule(static)
+		for (int job = 0; job < k; job++) {
+			bench.random_reader(bench.chunk_ptrs + (bench.n_chunks / k * job),
+					    size / 256, iter);
+		}
+	}
+	end = get_time();
+	bench.elapsed = end - start;
+	caculate_speed(c, start, iter, end, size * k, type);
+}
+
+/*
+ * Run the NEON random read kernel, or the random write kernel if @write is
+ * set, with @size bytes per thread. With @type >= 0 each chunk is prefetched
+ * @distance chunks ahead with that prefetch type, otherwise the plain kernel
+ * is the baseline. Returns the rate in MB/s.
+ */
+double run_prefetch(int write, int type, unsigned long distance, uint64_t size)
+{
+	uint64_t iter = bench.dynamic_iter ? (1ull << 32) / size : bench.max_iter;
+	int k = bench.threads;
+	double start, end;
+
+	start = get_time();
+#pragma omp parallel for schedule(static)
+	for (int job = 0; job < k; job++) {
+		unsigned long **ptrs = bench.chunk_ptrs + (bench.n_chunks / k * job);
+
+		if (type < 0 && write)
+			RandomWriterVector(ptrs, size / 256, iter, bench.value);
+		else if (type < 0)
+			RandomReaderVector(ptrs, size / 256, iter);
+		else if (write)
+			prefetch_writers[type](ptrs, size / 256, iter, bench.value, distance);
+		else
+			prefetch_readers[type](ptrs, size / 256, iter, distance);
+	}
+	end = get_time();
+	return (double)size * k * iter / 1024 / 1024 / (end - start);
+}
+
+/*
+ * Geometric midpoint of @lo and @hi, rounded down to 1/16 of its power of two
+ * to keep the labels short. Returns 0 if no such size lies strictly inside.
+ */
+uint64_t bisect_size(uint64_t lo, uint64_t hi)
+{
+	uint64_t mid = sqrt((double)lo * hi);
+	uint64_t step = MIN_BLOCK_SIZE;
+
+	while (step * 32 <= mid)
+		step *= 2;
+	mid = mid / step * step;
+	return mid > lo && mid < hi ? mid : 0;
+}
+
+/*
+ * Run one kernel of an adaptive sweep, then rescale the bytes per thread of
+ * the next runs so that each takes about @target seconds.
+ */
+void run_timed_kernel(int type, int c, uint64_t size, double target)
+{
+	double bytes;
+
+	run_kernel(type, c, size);
+	if (!bench.dynamic_iter || bench.elapsed <= 0)
+		return;
+	bytes = bench.iter_bytes * fmin(fmax(target / bench.elapsed, 0.25), 4);
+	bench.iter_bytes = fmin(fmax(bytes, MIN_BLOCK_SIZE), 1ull << 35);
+}
+
+/*
+ * Sweep the working-set size from @min_size to @max_size bytes per thread.
+ * A coarse power-of-two grid is measured first, then the interval with the
+ * largest relative speed change of any of the @lines kernels is bisected
+ * (geometric midpoint), as long as that change exceeds @threshold and the
+ * interval is wider than @resolution. Refinement stops when no interval
+ * qualifies, the point table is full or @budget seconds have elapsed.
+ * With dynamic iterations every run is scaled to take a share of @budget
+ * such that the coarse grid uses about half of it, and the grid itself is
+ * cut short at the deadline. Returns the number of points, sorted by size.
+ */
+int adaptive_sweep(int lines, uint64_t min_size, uint64_t max_size, double budget,
+		   double threshold, double resolution)
+{
+	uint64_t sizes[128];
+	double deadline = get_time() + budget;
+	double target;
+	int c = 0, grid = 1;
+
+	if (max_size < min_size) {
+		printf("Size per thread is below %lu bytes, nothing to sweep\n", min_size);
+		return 0;
+	}
+	for (uint64_t size = min_size; size < max_size; size *= 2)
+		grid++;
+	target = budget / 2 / grid / lines;
+	bench.iter_bytes = 1 << 24;
+
+	for (uint64_t size = min_size; c < 128; size *= 2) {
+		if (size > max_size)
+			size = max_size / MIN_BLOCK_SIZE * MIN_BLOCK_SIZE;
+		if (c && size <= sizes[c - 1])
+			break;
+		if (c && get_time() >= deadline) {
+			printf("Budget used up, grid stopped before %lu\n", size);
+			break;
+		}
+		sizes[c] = size;
+		for (int type = 0; type < lines; type++)
+			run_timed_kernel(type, c, size, target);
+		c++;
+	}
+
+	while (c < 128 && get_time() < deadline) {
+		double best_delta = threshold;
+		uint64_t mid;
+		int best = -1;
+
+		for (int i = 0; i + 1 < c; i++) {
+			if (sizes[i + 1] < sizes[i] * (1 + resolution) ||
+			    !bisect_size(sizes[i], sizes[i + 1]))
+				continue;
+			for (int type = 0; type < lines; type++) {
+				double y0 = ypoint[type][i], y1 = ypoint[type][i + 1];
+				double delta = fabs(y1 - y0) / fmax(y0, y1);
+
+				if (delta > best_delta) {
+					best_delta = delta;
+					best = i;
+				}
+			}
+		}
+		if (best < 0)
+			break;
+
+		mid = bisect_size(sizes[best], sizes[best + 1]);
+		printf("Refine %lu - %lu, change = %.1f%%\n", sizes[best], sizes[best + 1],
+		       best_delta * 100);
+
+		memmove(&sizes[best + 2], &sizes[best + 1], (c - best - 1) * sizeof(sizes[0]));
+		memmove(xlabel[best + 2], xlabel[best + 1], (c - best - 1) * sizeof(xlabel[0]));
+		for (int type = 0; type < lines; type++)
+			memmove(&ypoint[type][best + 2], &ypoint[type][best + 1],
+				(c - best - 1) * sizeof(ypoint[0][0]));
+		sizes[best + 1] = mid;
+		for (int type = 0; type < lines; type++)
+			run_timed_kernel(type, best + 1, mid, target);
+		c++;
+	}
+	printf("Adaptive sweep: %d points in %.1fs\n", c, get_time() - deadline + budget);
+	return c;
+}
+
+void output_results(char *file_name, char *job_name, char *xlabels, char *ylabels,
+		    double y[][128], const char *line_titles[], int lines, int c, int save_as_file)
+{
+	if (save_as_file) {
+		create_file(file_name, job_name, xlabels, ylabels);
+		save_label(XLABEL_STR_SIZE, xlabel, c, line_titles, lines);
+		for (int i = 0; i < lines; i++)
+			save_data(y[i], c);
+		close_file();
+	} else {
+		create_plot(file_name, job_name, xlabels, ylabels);
+		set_label(XLABEL_STR_SIZE, xlabel, c, line_titles, lines);
+		for (int i = 0; i < lines; i++)
+			write_data(y[i], c);
+		draw_plot();
+	}
+}
+
 int main(int argc, char *argv[])
 {
 	int opt = 0;
@@ -189,13 +493,16 @@ int main(int argc, char *argv[])
 	uint64_t curr_size = MIN_BLOCK_SIZE;
 	void *src, *dest;
 	int k, c, t = 0, dynamic_iter = 1;
-	double start, end;
+	int adaptive = 0, offset = 0;
+	int use_sve = 0, no_sve = 0;
+	double budget = 0, threshold = 0.1, resolution = 0.1;
+	struct access_param ap = { .theta = 0.99, .hot_set = 0.2, .hot_access = 0.8, .scan = 0.5 };
 	uint64_t value = 0x1234567689abcdef;
 	char job_name[256] = { 0 };
 	char file_name[256] = { 0 };
 	char tmp[128] = { 0 };
 
-	while ((opt = getopt(argc, argv, "ds:i:n:t:f:j:S:")) != -1) {
+	while ((opt = getopt(argc, argv, "ds:i:n:t:f:j:S:a:g:r:o:Nz:H:m:")) != -1) {
 		switch (opt) {
 		case 's':
 			max_size = atoi(optarg);
@@ -223,7 +530,10 @@ int main(int argc, char *argv[])
 				}
 			}
 			if (test == -1) {
-				printf("Usage -f [memcpy|bandwidth|matrix]\n");
+				printf("Usage -f [");
+				for (int i = 0; i < TEST_MAX; i++)
+					printf("%s%s", i ? "|" : "", test_name[i]);
+				printf("]\n");
 				exit(1);
 			}
 			break;
@@ -233,10 +543,54 @@ int main(int argc, char *argv[])
 		case 'd':
 			save_as_file = 1;
 			break;
+		case 'a':
+			budget = atof(optarg);
+			adaptive = 1;
+			break;
+		case 'g':
+			threshold = atof(optarg) / 100;
+			break;
+		case 'r':
+			resolution = atof(optarg) / 100;
+			break;
+		case 'o':
+			offset = atoi(optarg) & 4095;
+			break;
+		case 'N':
+			no_sve = 1;
+			break;
+		case 'z':
+			ap.theta = atof(optarg);
+			if (!(ap.theta >= 0 && ap.theta <= 10)) {
+				fprintf(stderr, "-z expects a zipf theta from 0 to 10\n");
+				exit(1);
+			}
+			break;
+		case 'H':
+			if (sscanf(optarg, "%lf:%lf", &ap.hot_set, &ap.hot_access) != 2 ||
+			    !(ap.hot_set > 0 && ap.hot_set < 100) ||
+			    !(ap.hot_access >= 0 && ap.hot_access <= 100)) {
+				fprintf(stderr, "-H expects hot_set_%%:hot_access_%%, "
+						"0 < hot_set < 100 and hot_access <= 100\n");
+				exit(1);
+			}
+			ap.hot_set /= 100;
+			ap.hot_access /= 100;
+			break;
+		case 'm':
+			ap.scan = atof(optarg) / 100;
+			if (!(ap.scan >= 0 && ap.scan <= 1)) {
+				fprintf(stderr, "-m expects a scan share from 0 to 100\n");
+				exit(1);
+			}
+			break;
 		default:
 			fprintf(stderr,
 				"Usage: %s [-s max_size] [-i max_iter] [-n nice_value] [-t num_threads]"
-				"[-f test case] [-j job_name] [-d save data as file]\n",
+				"[-f test case] [-j job_name] [-d save data as file]"
+				"[-a adaptive budget_s] [-g threshold_%%] [-r resolution_%%]"
+				"[-o string offset] [-N NEON only] [-z zipf theta]"
+				"[-H hot_set_%%:hot_access_%%] [-m scan_%%]\n",
 				argv[0]);
 			exit(1);
 		}
@@ -248,6 +602,14 @@ int main(int argc, char *argv[])
 	printf("max_size = %dMB, max_iter = %d, nice = %d\n", max_size / 1024 / 1024, max_iter,
 	       nice);
 
+	if (!no_sve && (getauxval(AT_HWCAP) & HWCAP_SVE)) {
+		use_sve = 1;
+		printf("SVE%s vector length = %d bits\n",
+		       getauxval(AT_HWCAP2) & HWCAP2_SVE2 ? "2" : "", SVEVectorLength() * 8);
+	} else {
+		printf("NEON vector length = 128 bits\n");
+	}
+
 	if (setpriority(PRIO_PROCESS, 0, nice) == -1) {
 		perror("setpriority");
 		exit(1);
@@ -275,6 +637,11 @@ int main(int argc, char *argv[])
 
 	snprintf(tmp, sizeof(tmp), " %dThread %s ", k, test_name[test]);
 	strcat(job_name, tmp);
+	if (use_sve && test != TEST_FAULT && test != TEST_STRING && test != TEST_PREFETCH &&
+	    test != TEST_SKEW) {
+		snprintf(tmp, sizeof(tmp), "SVE%d ", SVEVectorLength() * 8);
+		strcat(job_name, tmp);
+	}
 	omp_capture_affinity(tmp, sizeof(tmp), "CPU%{thread_affinity}");
 	strcat(job_name, tmp);
 
@@ -286,6 +653,21 @@ int main(int argc, char *argv[])
 			file_name[i] = '_';
 	}
 	strcat(file_name, save_as_file ? ".dat" : ".svg");
+	bench.max_size = max_size;
+	bench.value = value;
+	bench.threads = k;
+	bench.test = test;
+	bench.dynamic_iter = dynamic_iter;
+	bench.max_iter = max_iter;
+	bench.iter_bytes = 1ull << 35;
+	bench.copy = use_sve ? memcpy_sve : memcpy_arm64;
+	bench.reader = use_sve ? ReaderSVE : ReaderVector;
+	bench.random_reader = use_sve ? RandomReaderSVE : RandomReaderVector;
+	bench.writer = use_sve ? WriterSVE : WriterVector;
+	bench.random_writer = use_sve ? RandomWriterSVE : RandomWriterVector;
+	if (test_single_size)
+		adaptive = 0;
+
 	if (test == TEST_MEMCPY) {
 		src = aligned_alloc(1024, max_size);
 		if (src == NULL) {
@@ -298,22 +680,20 @@ int main(int argc, char *argv[])
 			fprintf(stderr, "aligned_alloc failed\n");
 			exit(1);
 		}
+		/* Keep first-touch page faults out of the timed loops. */
+		memset(src, 0, max_size);
+		memset(dest, 0, max_size);
 		printf("src = %p, dest = %p\n", src, dest);
+		bench.src = src;
+		bench.dest = dest;
 		c = 0;
 		if (test_single_size)
 			curr_size = max_size / k;
-		while ((curr_size * k) <= max_size) {
-			iter = dynamic_iter ? (1ull << 35) / curr_size : max_iter;
-			start = get_time();
-#pragma omp parallel for schedule(static)
-			for (int job = 0; job < k; job++) {
-				for (int i = 0; i < iter; i++) {
-					memcpy_arm64(dest + (max_size / k * job),
-						     (src + (max_size / k) * job), curr_size);
-				}
-			}
-			end = get_time();
-			caculate_speed(c, start, iter, end, curr_size * k, PTYPE_MEMCPY);
+		if (adaptive)
+			c = adaptive_sweep(1, MIN_BLOCK_SIZE, max_size / k, budget, threshold,
+					   resolution);
+		while (!adaptive && (curr_size * k) <= max_size) {
+			run_kernel(PTYPE_MEMCPY, c, curr_size);
 			c++;
 			curr_size *= 2;
 		}
@@ -339,47 +719,7 @@ int main(int argc, char *argv[])
 			fprintf(stderr, "aligned_alloc failed\n");
 			exit(1);
 		}
-
-		c = 0;
-		if (test_single_size)
-			curr_size = max_size / k;
-		else
-			curr_size = cache_sizes[c];
-		printf("Test Write Vector\n");
-		while ((curr_size * k) <= max_size) {
-			iter = dynamic_iter ? (1ull << 35) / curr_size : max_iter;
-			start = get_time();
-#pragma omp parallel for schedule(static)
-			for (int job = 0; job < k; job++) {
-				WriterVector(src + (max_size / k * job), curr_size, iter, value);
-			}
-			end = get_time();
-			caculate_speed(c, start, iter, end, curr_size * k, PTYPE_WRITE);
-			c++;
-			if (c >= (sizeof(cache_sizes) / sizeof(cache_sizes[0])))
-				break;
-			curr_size = cache_sizes[c];
-		}
-		c = 0;
-		if (test_single_size)
-			curr_size = max_size / k;
-		else
-			curr_size = cache_sizes[c];
-		printf("Test Read Vector\n");
-		while ((curr_size * k) <= max_size) {
-			iter = dynamic_iter ? (1ull << 35) / curr_size : max_iter;
-			start = get_time();
-#pragma omp parallel for schedule(static)
-			for (int job = 0; job < k; job++) {
-				ReaderVector(src + (max_size / k * job), curr_size, iter);
-			}
-			end = get_time();
-			caculate_speed(c, start, iter, end, curr_size * k, PTYPE_READ);
-			c++;
-			if (c >= (sizeof(cache_sizes) / sizeof(cache_sizes[0])))
-				break;
-			curr_size = cache_sizes[c];
-		}
+		memset(src, 0, max_size);
 
 		unsigned long n_chunks = max_size / 256;
 		unsigned long **chunk_ptrs =
@@ -387,48 +727,33 @@ int main(int argc, char *argv[])
 		for (int i = 0; i < n_chunks; i++) {
 			chunk_ptrs[i] = (unsigned long *)(src + i * 256);
 		}
-		shuffle_array(*chunk_ptrs, n_chunks);
-		c = 0;
-		if (test_single_size)
-			curr_size = max_size / k;
-		else
-			curr_size = cache_sizes[c];
-		printf("Test Random Write Vector\n");
-		while ((curr_size * k) <= max_size) {
-			iter = dynamic_iter ? (1ull << 35) / curr_size : max_iter;
-			start = get_time();
-#pragma omp parallel for schedule(static)
-			for (int job = 0; job < k; job++) {
-				RandomWriterVector(chunk_ptrs + (n_chunks / k * job),
-						   curr_size / 256, iter, value);
-			}
-			end = get_time();
-			caculate_speed(c, start, iter, end, curr_size * k, PTYPE_RANDOM_WRITE);
-			c++;
-			if (c >= (sizeof(cache_sizes) / sizeof(cache_sizes[0])))
-				break;
-			curr_size = cache_sizes[c];
+		shuffle_array(chunk_ptrs, n_chunks);
+		bench.src = src;
+		bench.chunk_ptrs = chunk_ptrs;
+		bench.n_chunks = n_chunks;
+
+		if (adaptive) {
+			printf("Test Write/Read/Random Write/Random Read Vector\n");
+			c = adaptive_sweep(PTYPE_MAX, MIN_BLOCK_SIZE, max_size / k, budget,
+					   threshold, resolution);
 		}
-		c = 0;
-		if (test_single_size)
-			curr_size = max_size / k;
-		else
-			curr_size = cache_sizes[c];
-		printf("Test Random Read Vector\n");
-		while ((curr_size * k) <= max_size) {
-			iter = dynamic_iter ? (1ull << 35) / curr_size : max_iter;
-			start = get_time();
-#pragma omp parallel for schedule(static)
-			for (int job = 0; job < k; job++) {
-				RandomReaderVector(chunk_ptrs + (n_chunks / k * job),
-						   curr_size / 256, iter);
+		for (int type = 0; type < PTYPE_MAX && !adaptive; type++) {
+			const char *kernel_names[] = { "Write", "Read", "Random Write",
+						       "Random Read" };
+
+			c = 0;
+			if (test_single_size)
+				curr_size = max_size / k;
+			else
+				curr_size = cache_sizes[c];
+			printf("Test %s Vector\n", kernel_names[type]);
+			while ((curr_size * k) <= max_size) {
+				run_kernel(type, c, curr_size);
+				c++;
+				if (c >= (sizeof(cache_sizes) / sizeof(cache_sizes[0])))
+					break;
+				curr_size = cache_sizes[c];
 			}
-			end = get_time();
-			caculate_speed(c, start, iter, end, curr_size * k, PTYPE_RANDOM_READ);
-			c++;
-			if (c >= (sizeof(cache_sizes) / sizeof(cache_sizes[0])))
-				break;
-			curr_size = cache_sizes[c];
 		}
 
 		const char *line_titles[] = { "Write", "Read", "Random Write", "Random Read" };
@@ -452,7 +777,7 @@ int main(int argc, char *argv[])
 		N = test_single_size ? max_size : 512;
 		for (i = 0; N <= max_size; N += 64, i++) {
 			float_matrix_performance_test(N, &ypoint[0][i], &ypoint[1][i],
-						      &ypoint[2][i], &ypoint[3][i]);
+						      &ypoint[2][i], &ypoint[3][i], use_sve);
 			snprintf(xlabel[i], sizeof(xlabel[i]), "%d", N);
 		}
 		const char *line_titles[] = { "f32 Scalar", "f32 Vector", "f64 Scalar",
@@ -471,6 +796,350 @@ int main(int argc, char *argv[])
 			draw_plot();
 		}
 	}
-	printf("Save file: %s\n", file_name);
+	if (test == TEST_FAULT) {
+		double fault_rate[FAULT_LINES][128];
+		double fr[FAULT_MAX], bw[FAULT_MAX];
+		size_t hpage = fault_huge_page_size();
+		size_t len = strlen(file_name) - 4;
+		char rate_name[300];
+		int n = 1;
+
+		printf("Base page = %ldKB, Huge page = %luKB\n", sysconf(_SC_PAGESIZE) / 1024,
+		       hpage / 1024);
+		iter = dynamic_iter ? 16 : max_iter;
+		for (c = 0;; c++) {
+			curr_size = test_single_size ? max_size : max_size / n;
+			curr_size = curr_size / hpage * hpage;
+			if (curr_size == 0)
+				curr_size = hpage;
+			for (int huge = 0; huge < 2; huge++) {
+				fault_performance_test(n, curr_size, iter, huge, fr, bw);
+				for (int op = 0; op < FAULT_MAX; op++) {
+					int line = fault_line(op, huge);
+
+					if (line < 0)
+						continue;
+					fault_rate[line][c] = fr[op];
+					ypoint[line][c] = bw[op];
+				}
+			}
+			snprintf(xlabel[c], sizeof(xlabel[c]), "%dT", n);
+			if (n == k)
+				break;
+			n = n * 2 > k ? k : n * 2;
+		}
+		c++;
+
+		const char *line_titles[] = { "Touch",	      "Touch THP",    "mmap",
+					      "mmap THP",     "DONTNEED",     "DONTNEED THP",
+					      "Collapse THP" };
+		output_results(file_name, job_name, "Threads", "Rate (GB/s)", ypoint, line_titles,
+			       FAULT_LINES, c, save_as_file);
+		snprintf(rate_name, sizeof(rate_name), "%.*s_faults%s", (int)len, file_name,
+			 file_name + len);
+		output_results(rate_name, job_name, "Threads", "Faults (per second)", fault_rate,
+			       line_titles, FAULT_LINES, c, save_as_file);
+		printf("Save file: %s\n", rate_name);
+	}
+	if (test == TEST_STRING) {
+		double latency[IMPL_MAX][128];
+		uint64_t region = max_size / k / 4096 * 4096;
+		uint64_t sweep_size = STR_SWEEP_SIZE, pos_size, pos;
+		size_t len = strlen(file_name) - 4;
+		int impls = use_sve ? IMPL_MAX : IMPL_SVE;
+		char name[300];
+		int errors;
+
+		errors = string_check(impls);
+		if (errors)
+			printf("\033[31m%d string routine results are incorrect\033[0m\n", errors);
+
+		src = aligned_alloc(4096, max_size);
+		if (src == NULL) {
+			fprintf(stderr, "aligned_alloc failed\n");
+			exit(1);
+		}
+		memset(src, 0, max_size);
+		printf("src = %p, offset = %d\n", src, offset);
+		while (sweep_size > 1 && (sweep_size * 3 / 2 + STR_MAX_OFFSET) * 2 > region)
+			sweep_size /= 2;
+		/* The position sweep runs at -o offset, which may be up to 4095. */
+		pos_size = sweep_size;
+		while (pos_size && (pos_size + offset) * 2 > region)
+			pos_size /= 2;
+
+		const char *line_titles[] = { "glibc", "arm64", "naive", "sve" };
+		for (int routine = 0; routine < STR_MAX; routine++) {
+			printf("Test %s\n", string_routine_name[routine]);
+			/* 1, 2, 3, 4, 6, 8, 12 ... so tails are covered as well. */
+			for (c = 0, curr_size = 1; (curr_size * 3 / 2 + offset) * 2 <= region;
+			     c++) {
+				iter = dynamic_iter ? (1ull << 29) / (curr_size + 64) : max_iter;
+				for (int impl = 0; impl < impls; impl++)
+					string_performance_test(routine, impl, src, region,
+								curr_size, curr_size - 1, offset, k,
+								iter, &ypoint[impl][c],
+								&latency[impl][c]);
+				format_size(xlabel[c], sizeof(xlabel[c]), curr_size);
+				printf("Size = %s", xlabel[c]);
+				for (int impl = 0; impl < impls; impl++)
+					printf(", %s = %.2fMB/s %.1fns", line_titles[impl],
+					       ypoint[impl][c], latency[impl][c]);
+				printf("\n");
+				if (curr_size & (curr_size - 1))
+					curr_size = curr_size / 3 * 4;
+				else
+					curr_size = curr_size < 2 ? 2 : curr_size * 3 / 2;
+			}
+
+			snprintf(name, sizeof(name), "%.*s_%s%s", (int)len, file_name,
+				 string_routine_name[routine], file_name + len);
+			output_results(name, job_name, "Block Size", "Rate (MB/s)", ypoint,
+				       line_titles, impls, c, save_as_file);
+			printf("Save file: %s\n", name);
+			snprintf(name, sizeof(name), "%.*s_%s_latency%s", (int)len, file_name,
+				 string_routine_name[routine], file_name + len);
+			output_results(name, job_name, "Block Size", "Time (ns)", latency,
+				       line_titles, impls, c, save_as_file);
+			printf("Save file: %s\n", name);
+
+			/* Same size at every offset within a cache line. */
+			iter = dynamic_iter ? (1ull << 29) / (sweep_size + 64) : max_iter;
+			for (c = 0; c < STR_MAX_OFFSET; c++) {
+				for (int impl = 0; impl < impls; impl++)
+					string_performance_test(routine, impl, src, region,
+								sweep_size, sweep_size - 1, c, k,
+								iter, &ypoint[impl][c],
+								&latency[impl][c]);
+				snprintf(xlabel[c], sizeof(xlabel[c]), "%d", c);
+			}
+			format_size(name, sizeof(name), sweep_size);
+			printf("Size = %s, offset 0 - %d:", name, STR_MAX_OFFSET - 1);
+			for (int impl = 0; impl < impls; impl++) {
+				double lo = ypoint[impl][0], hi = ypoint[impl][0];
+
+				for (int i = 1; i < c; i++) {
+					lo = fmin(lo, ypoint[impl][i]);
+					hi = fmax(hi, ypoint[impl][i]);
+				}
+				printf(" %s = %.2f - %.2fMB/s", line_titles[impl], lo, hi);
+			}
+			printf("\n");
+			snprintf(name, sizeof(name), "%.*s_%s_align%s", (int)len, file_name,
+				 string_routine_name[routine], file_name + len);
+			output_results(name, job_name, "Offset (bytes)", "Rate (MB/s)", ypoint,
+				       line_titles, impls, c, save_as_file);
+			printf("Save file: %s\n", name);
+
+			if (routine != STR_MEMCMP && routine != STR_MEMCHR && routine != STR_STRLEN)
+				continue;
+			if (!pos_size) {
+				printf("Offset %d leaves no room for the position sweep\n", offset);
+				continue;
+			}
+
+			/* Match at 0, 1, 2, 4 ... bytes into a buffer of fixed size. */
+			iter = dynamic_iter ? (1ull << 29) / (pos_size + 64) : max_iter;
+			for (c = 0, pos = 0;; c++) {
+				for (int impl = 0; impl < impls; impl++)
+					string_performance_test(routine, impl, src, region,
+								pos_size, pos, offset, k, iter,
+								&ypoint[impl][c], &latency[impl][c]);
+				snprintf(xlabel[c], sizeof(xlabel[c]), "%lu", pos);
+				printf("Position = %sB", xlabel[c]);
+				for (int impl = 0; impl < impls; impl++)
+					printf(", %s = %.1fns", line_titles[impl], latency[impl][c]);
+				printf("\n");
+				if (pos == pos_size - 1)
+					break;
+				pos = pos ? pos * 2 : 1;
+				if (pos >= pos_size)
+					pos = pos_size - 1;
+			}
+			c++;
+			snprintf(name, sizeof(name), "%.*s_%s_position%s", (int)len, file_name,
+				 string_routine_name[routine], file_name + len);
+			output_results(name, job_name, "Match Position (bytes)", "Time (ns)", latency,
+				       line_titles, impls, c, save_as_file);
+			printf("Save file: %s\n", name);
+		}
+		free(src);
+	}
+	if (test == TEST_PREFETCH) {
+		double speedup[2][PF_MAX][PF_DISTANCES][128];
+		char dist_titles[PF_DISTANCES][16];
+		const char *line_titles[PF_DISTANCES];
+		const char *rw_name[] = { "read", "write" };
+		size_t len = strlen(file_name) - 4;
+		char name[300];
+
+		src = aligned_alloc(1024, max_size);
+		if (src == NULL) {
+			fprintf(stderr, "aligned_alloc failed\n");
+			exit(1);
+		}
+		memset(src, 0, max_size);
+
+		unsigned long n_chunks = max_size / 256;
+		unsigned long **chunk_ptrs =
+			(unsigned long **)malloc(n_chunks * sizeof(unsigned long *));
+		for (int i = 0; i < n_chunks; i++) {
+			chunk_ptrs[i] = (unsigned long *)(src + i * 256);
+		}
+		shuffle_array(chunk_ptrs, n_chunks);
+		bench.src = src;
+		bench.chunk_ptrs = chunk_ptrs;
+		bench.n_chunks = n_chunks;
+
+		for (c = 0, curr_size = test_single_size ? max_size / k : 4096;
+		     curr_size * k <= max_size && curr_size >= 256; c++, curr_size *= 2) {
+			format_size(xlabel[c], sizeof(xlabel[c]), curr_size);
+			for (int write = 0; write < 2; write++) {
+				double base = run_prefetch(write, -1, 0, curr_size);
+				double best = 0;
+				int best_type = 0, best_dist = 0;
+
+				for (int type = 0; type < PF_MAX; type++) {
+					for (int d = 0; d < PF_DISTANCES; d++) {
+						double s = run_prefetch(write, type,
+									prefetch_distance[d],
+									curr_size) / base;
+
+						speedup[write][type][d][c] = s;
+						if (s > best) {
+							best = s;
+							best_type = type;
+							best_dist = prefetch_distance[d];
+						}
+					}
+				}
+				printf("Size = %s, Random %s = %.2fMB/s, best %s distance %d, "
+				       "speedup = %.2f\n",
+				       xlabel[c], rw_name[write], base,
+				       prefetch_type_name[write][best_type], best_dist, best);
+			}
+		}
+
+		for (int d = 0; d < PF_DISTANCES; d++) {
+			snprintf(dist_titles[d], sizeof(dist_titles[d]), "Distance %d",
+				 prefetch_distance[d]);
+			line_titles[d] = dist_titles[d];
+		}
+		for (int write = 0; write < 2; write++) {
+			for (int type = 0; type < PF_MAX; type++) {
+				snprintf(name, sizeof(name), "%.*s_%s_%s%s", (int)len, file_name,
+					 rw_name[write], prefetch_type_name[write][type],
+					 file_name + len);
+				output_results(name, job_name, "Block Size", "Speedup",
+					       speedup[write][type], line_titles, PF_DISTANCES, c,
+					       save_as_file);
+				printf("Save file: %s\n", name);
+			}
+		}
+		free(chunk_ptrs);
+		free(src);
+	}
+	if (test == TEST_SKEW) {
+		double hit_rate[4][DIST_MAX][128];
+		double capacity[4];
+		int level[4], levels;
+		size_t len = strlen(file_name) - 4;
+		char name[300], size_str[32];
+
+		levels = cache_capacities(k, level, capacity, 4);
+		if (!levels)
+			printf("Cache sizes not found, hit rates are not estimated\n");
+		for (int l = 0; l < levels; l++) {
+			format_size(size_str, sizeof(size_str), capacity[l]);
+			printf("L%d = %s per thread\n", level[l], size_str);
+		}
+		printf("Zipf theta = %.2f, Hot/Cold = %.0f%% of the set takes %.0f%% of accesses, "
+		       "Scan Mix = %.0f%% sequential\n",
+		       ap.theta, ap.hot_set * 100, ap.hot_access * 100, ap.scan * 100);
+
+		src = aligned_alloc(1024, max_size);
+		if (src == NULL) {
+			fprintf(stderr, "aligned_alloc failed\n");
+			exit(1);
+		}
+		memset(src, 0, max_size);
+
+		unsigned long n_chunks = max_size / 256;
+		/* Room for four indexes per chunk of the largest size. */
+		unsigned long max_slen = n_chunks / k * 4;
+		if (max_slen < STREAM_MIN_LEN)
+			max_slen = STREAM_MIN_LEN;
+		uint32_t *streams = (uint32_t *)malloc(k * max_slen * sizeof(uint32_t));
+		if (streams == NULL) {
+			fprintf(stderr, "malloc failed\n");
+			exit(1);
+		}
+
+		for (c = 0, curr_size = test_single_size ? max_size / k : 4096;
+		     curr_size * k <= max_size && curr_size >= 256; c++, curr_size *= 2) {
+			unsigned long n = curr_size / 256;
+			/*
+			 * Four draws per chunk follow the distribution closely enough.
+			 * The stream is then 1/16 of the data it indexes at every size
+			 * from 16KB up, below that STREAM_MIN_LEN applies.
+			 */
+			unsigned long slen = n * 4 < STREAM_MIN_LEN ? STREAM_MIN_LEN : n * 4;
+			uint64_t loops = dynamic_iter ? (1ull << 32) / (slen * 256) : max_iter;
+			double start, end;
+
+			if (!loops)
+				loops = 1;
+
+			format_size(xlabel[c], sizeof(xlabel[c]), curr_size);
+			format_size(size_str, sizeof(size_str), slen * sizeof(uint32_t));
+			printf("Size = %s, stream = %s per thread (%.1f%% of the data)\n", xlabel[c],
+			       size_str, 100.0 * slen * sizeof(uint32_t) / curr_size);
+
+			for (int dist = 0; dist < DIST_MAX; dist++) {
+#pragma omp parallel for schedule(static)
+				for (int job = 0; job < k; job++) {
+					access_stream(dist, &ap, n, streams + slen * job, slen,
+						      (uint64_t)c << 32 | job << 8 | dist);
+				}
+
+				start = get_time();
+#pragma omp parallel for schedule(static)
+				for (int job = 0; job < k; job++) {
+					unsigned long base = n_chunks / k * job;
+
+					RandomReaderIndex(src + base * 256, streams + slen * job, slen,
+							  loops);
+				}
+				end = get_time();
+
+				ypoint[dist][c] =
+					(double)slen * 256 * loops * k / 1024 / 1024 / (end - start);
+				printf("Size = %s, %s = %.2fMB/s", xlabel[c], access_dist_name[dist],
+				       ypoint[dist][c]);
+				for (int l = 0; l < levels; l++) {
+					hit_rate[l][dist][c] =
+						access_hit_rate(dist, &ap, n, capacity[l] / 256) * 100;
+					printf(", L%d hit = %.1f%%", level[l], hit_rate[l][dist][c]);
+				}
+				printf("\n");
+			}
+		}
+
+		const char *line_titles[] = { "Uniform", "Zipf", "Hot/Cold", "Scan Mix" };
+		output_results(file_name, job_name, "Block Size", "Rate (MB/s)", ypoint, line_titles,
+			       DIST_MAX, c, save_as_file);
+		for (int l = 0; l < levels; l++) {
+			snprintf(name, sizeof(name), "%.*s_hit_l%d%s", (int)len, file_name, level[l],
+				 file_name + len);
+			output_results(name, job_name, "Block Size", "Estimated Hit Rate (%)",
+				       hit_rate[l], line_titles, DIST_MAX, c, save_as_file);
+			printf("Save file: %s\n", name);
+		}
+		free(streams);
+		free(src);
+	}
+	/* string and prefetch only write their own suffixed files. */
+	if (test != TEST_STRING && test != TEST_PREFETCH)
+		printf("Save file: %s\n", file_name);
 	return 0;
 }
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2024 Xuran Yang
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * SVE matrix multiply kernels. This file is built with +sve, so nothing in
+ * it may run unless the CPU reports HWCAP_SVE.
+ */
+
+#include <arm_sve.h>
+
+/*
+ * Same column-major layout as matrix_multiply_vector(): one vector of rows
+ * of A times four columns of B per step, the row tail is handled by the
+ * whilelt predicate so any vector length works.
+ */
+void matrix_multiply_sve(const double *A, const double *B, double *C, int N)
+{
+#pragma omp parallel for
+	for (int jj = 0; jj < N; jj += 4) {
+		for (int ii = 0; ii < N; ii += (int)svcntd()) {
+			svbool_t pg = svwhilelt_b64(ii, N);
+			svfloat64_t C0 = svdup_f64(0);
+			svfloat64_t C1 = svdup_f64(0);
+			svfloat64_t C2 = svdup_f64(0);
+			svfloat64_t C3 = svdup_f64(0);
+			for (int kk = 0; kk < N; kk++) {
+				svfloat64_t A0 = svld1_f64(pg, A + ii + N * kk);
+				int Bi = N * jj + kk;
+
+				C0 = svmla_n_f64_x(pg, C0, A0, B[Bi]);
+				C1 = svmla_n_f64_x(pg, C1, A0, B[Bi + N]);
+				C2 = svmla_n_f64_x(pg, C2, A0, B[Bi + 2 * N]);
+				C3 = svmla_n_f64_x(pg, C3, A0, B[Bi + 3 * N]);
+			}
+			int Ci = N * jj + ii;
+			svst1_f64(pg, C + Ci, C0);
+			svst1_f64(pg, C + Ci + N, C1);
+			svst1_f64(pg, C + Ci + 2 * N, C2);
+			svst1_f64(pg, C + Ci + 3 * N, C3);
+		}
+	}
+}
+
+void matrix_multiply_sve(const float *A, const float *B, float *C, int N)
+{
+#pragma omp parallel for
+	for (int jj = 0; jj < N; jj += 4) {
+		for (int ii = 0; ii < N; ii += (int)svcntw()) {
+			svbool_t pg = svwhilelt_b32(ii, N);
+			svfloat32_t C0 = svdup_f32(0);
+			svfloat32_t C1 = svdup_f32(0);
+			svfloat32_t C2 = svdup_f32(0);
+			svfloat32_t C3 = svdup_f32(0);
+			for (int kk = 0; kk < N; kk++) {
+				svfloat32_t A0 = svld1_f32(pg, A + ii + N * kk);
+				int Bi = N * jj + kk;
+
+				C0 = svmla_n_f32_x(pg, C0, A0, B[Bi]);
+				C1 = svmla_n_f32_x(pg, C1, A0, B[Bi + N]);
+				C2 = svmla_n_f32_x(pg, C2, A0, B[Bi + 2 * N]);
+				C3 = svmla_n_f32_x(pg, C3, A0, B[Bi + 3 * N]);
+			}
+			int Ci = N * jj + ii;
+			svst1_f32(pg, C + Ci, C0);
+			svst1_f32(pg, C + Ci + N, C1);
+			svst1_f32(pg, C + Ci + 2 * N, C2);
+			svst1_f32(pg, C + Ci + 3 * N, C3);
+		}
+	}
+}
@@ -23,6 +23,9 @@
 #include <arm_neon.h>
 #include <cstring>
 
+void matrix_multiply_sve(const double *A, const double *B, double *C, int N);
+void matrix_multiply_sve(const float *A, const float *B, float *C, int N);
+
 template <typename T> struct Tolerance;
 
 template <> struct Tolerance<double> {
@@ -146,7 +149,8 @@ template <typename T> T check_results(T *C1, T *C2, const int N)
 	return max_diff;
 }
 
-template <typename T> void matrix_performance_test(int N, double *scalar_time, double *vector_time)
+template <typename T>
+void matrix_performance_test(int N, double *scalar_time, double *vector_time, int use_sve)
 {
 	srand(static_cast<unsigned>(time(0)));
 
@@ -169,10 +173,14 @@ template <typename T> void matrix_performance_test(int N, double *scalar_time, d
 	std::cout << typeid(T).name() << " Matrix " << N << " Scalar: " << *scalar_time << " s\n";
 
 	start = omp_get_wtime();
-	matrix_multiply_vector((const T *)A, (const T *)B, C2, N);
+	if (use_sve)
+		matrix_multiply_sve((const T *)A, (const T *)B, C2, N);
+	else
+		matrix_multiply_vector((const T *)A, (const T *)B, C2, N);
 	end = omp_get_wtime();
 	*vector_time = end - start;
-	std::cout << typeid(T).name() << " Matrix " << N << " Vector: " << *vector_time << " s\n";
+	std::cout << typeid(T).name() << " Matrix " << N << (use_sve ? " SVE: " : " Vector: ")
+		  << *vector_time << " s\n";
 
 	T max_difference = check_results(C1, C2, N);
 	if (max_difference < Tolerance<T>::value) {
@@ -190,8 +198,8 @@ template <typename T> void matrix_performance_test(int N, double *scalar_time, d
 }
 
 extern "C" void float_matrix_performance_test(int N, double *f64_s_t, double *f64_v_t,
-					      double *f32_s_t, double *f32_v_t)
+					      double *f32_s_t, double *f32_v_t, int use_sve)
 {
-	matrix_performance_test<double>(N, f64_s_t, f64_v_t);
-	matrix_performance_test<float>(N, f32_s_t, f32_v_t);
+	matrix_performance_test<double>(N, f64_s_t, f64_v_t, use_sve);
+	matrix_performance_test<float>(N, f32_s_t, f32_v_t, use_sve);
 }
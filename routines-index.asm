@@ -0,0 +1,79 @@
+#============================================================================
+# Index stream variant of the random read routine.
+#
+# Copyright (C) 2024 Xuran Yang
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+# Works like RandomReaderVector, but the stream holds 32-bit chunk indexes
+# instead of 64-bit chunk pointers, so a precomputed stream costs 4 bytes
+# per 256-byte chunk read.
+#=============================================================================
+
+.arch armv8-a
+
+.global RandomReaderIndex
+
+.global _RandomReaderIndex
+
+.text
+
+#-----------------------------------------------------------------------------
+# Name: 	RandomReaderIndex
+# Purpose:	Performs random reads from memory driven by an index stream.
+# Params:
+# 	x0 = address of chunk 0
+# 	x1 = pointer to array of 32-bit chunk indexes
+# 	x2 = # of indexes
+# 	x3 = # loops to do
+#-----------------------------------------------------------------------------
+.align 4
+RandomReaderIndex:
+_RandomReaderIndex:
+
+1:
+	mov	x5, xzr
+
+2:
+	## Get pointer to chunk in memory.
+	ldr	w6, [x1, x5, lsl 2]
+	add	x4, x0, x6, lsl 8
+
+	## Does 16 transfers, 16 bytes each = 256 bytes total.
+	ldr	q0, [x4, 144]
+	ldr	q0, [x4, 48]
+	ldr	q0, [x4, 240]
+	ldr	q0, [x4, 16]
+	ldr	q0, [x4, 192]
+	ldr	q0, [x4, 80]
+	ldr	q0, [x4, 176]
+	ldr	q0, [x4, 64]
+	ldr	q0, [x4, 224]
+	ldr	q0, [x4, 32]
+	ldr	q0, [x4, 128]
+	ldr	q0, [x4]
+	ldr	q0, [x4, 160]
+	ldr	q0, [x4, 96]
+	ldr	q0, [x4, 208]
+	ldr	q0, [x4, 112]
+
+	add	x5, x5, 1
+	cmp	x5, x2
+	bne	2b
+
+	subs	x3, x3, 1
+	bne	1b
+
+	dsb	ld
+	ret
@@ -0,0 +1,183 @@
+#============================================================================
+# Software prefetch variants of the random access routines.
+#
+# Copyright (C) 2024 Xuran Yang
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+# Each routine works like RandomReaderVector / RandomWriterVector, but
+# before touching chunk i it prefetches the four cache lines of chunk
+# (i + distance) % n, so prefetches never leave the n chunk pointers the
+# routine was given. The prefetch type is an immediate, so there is one
+# routine per type.
+#=============================================================================
+
+.arch armv8-a
+
+.global RandomReaderPrefetchL1Keep
+.global RandomReaderPrefetchL2Keep
+.global RandomReaderPrefetchL1Strm
+.global RandomWriterPrefetchL1Keep
+.global RandomWriterPrefetchL2Keep
+.global RandomWriterPrefetchL1Strm
+
+.global _RandomReaderPrefetchL1Keep
+.global _RandomReaderPrefetchL2Keep
+.global _RandomReaderPrefetchL1Strm
+.global _RandomWriterPrefetchL1Keep
+.global _RandomWriterPrefetchL2Keep
+.global _RandomWriterPrefetchL1Strm
+
+.text
+
+#-----------------------------------------------------------------------------
+# Name: 	RandomReaderPrefetch*
+# Purpose:	Performs random reads from memory with software prefetch.
+# Params:
+# 	x0 = pointer to array of chunk pointers
+# 	x1 = # of 256-byte chunks
+# 	x2 = # loops to do
+# 	x3 = prefetch distance in chunks
+#-----------------------------------------------------------------------------
+.macro RANDOM_READER_PREFETCH name, type
+.align 4
+\name:
+_\name:
+	## Reduce the distance below n, one subtraction then wraps the index.
+	udiv	x6, x3, x1
+	msub	x3, x6, x1, x3
+
+1:
+	mov	x5, xzr
+
+2:
+	## Prefetch the chunk "distance" entries ahead.
+	add	x6, x5, x3
+	cmp	x6, x1
+	b.lo	3f
+	sub	x6, x6, x1
+3:
+	ldr	x7, [x0, x6, lsl 3]
+	prfm	\type, [x7]
+	prfm	\type, [x7, 64]
+	prfm	\type, [x7, 128]
+	prfm	\type, [x7, 192]
+
+	## Get pointer to chunk in memory.
+	ldr	x4, [x0, x5, lsl 3]
+
+	## Does 16 transfers, 16 bytes each = 256 bytes total.
+	ldr	q0, [x4, 144]
+	ldr	q0, [x4, 48]
+	ldr	q0, [x4, 240]
+	ldr	q0, [x4, 16]
+	ldr	q0, [x4, 192]
+	ldr	q0, [x4, 80]
+	ldr	q0, [x4, 176]
+	ldr	q0, [x4, 64]
+	ldr	q0, [x4, 224]
+	ldr	q0, [x4, 32]
+	ldr	q0, [x4, 128]
+	ldr	q0, [x4]
+	ldr	q0, [x4, 160]
+	ldr	q0, [x4, 96]
+	ldr	q0, [x4, 208]
+	ldr	q0, [x4, 112]
+
+	add	x5, x5, 1
+	cmp	x5, x1
+	bne	2b
+
+	subs	x2, x2, 1
+	bne	1b
+
+	dsb	ld
+	ret
+.endm
+
+#-----------------------------------------------------------------------------
+# Name: 	RandomWriterPrefetch*
+# Purpose:	Performs random writes into memory with software prefetch.
+# Params:
+# 	x0 = pointer to array of chunk pointers
+# 	x1 = # of 256-byte chunks
+# 	x2 = # loops to do
+# 	x3 = value to write
+# 	x4 = prefetch distance in chunks
+#-----------------------------------------------------------------------------
+.macro RANDOM_WRITER_PREFETCH name, type
+.align 4
+\name:
+_\name:
+	dup	v0.2d, x3
+	## Reduce the distance below n, one subtraction then wraps the index.
+	udiv	x6, x4, x1
+	msub	x4, x6, x1, x4
+
+1:
+	mov	x5, xzr
+
+2:
+	## Prefetch the chunk "distance" entries ahead.
+	add	x6, x5, x4
+	cmp	x6, x1
+	b.lo	3f
+	sub	x6, x6, x1
+3:
+	ldr	x7, [x0, x6, lsl 3]
+	prfm	\type, [x7]
+	prfm	\type, [x7, 64]
+	prfm	\type, [x7, 128]
+	prfm	\type, [x7, 192]
+
+	## Get pointer to chunk in memory.
+	ldr	x8, [x0, x5, lsl 3]
+
+	## Does 16 transfers, 16 bytes each = 256 bytes total.
+	str	q0, [x8, 144]
+	str	q0, [x8, 48]
+	str	q0, [x8, 240]
+	str	q0, [x8, 16]
+	str	q0, [x8, 192]
+	str	q0, [x8, 80]
+	str	q0, [x8, 176]
+	str	q0, [x8, 64]
+	str	q0, [x8, 224]
+	str	q0, [x8, 32]
+	str	q0, [x8, 128]
+	str	q0, [x8]
+	str	q0, [x8, 160]
+	str	q0, [x8, 96]
+	str	q0, [x8, 208]
+	str	q0, [x8, 112]
+
+	add	x5, x5, 1
+	cmp	x5, x1
+	bne	2b
+
+	subs	x2, x2, 1
+	bne	1b
+
+	dsb	st
+	ret
+.endm
+
+RANDOM_READER_PREFETCH RandomReaderPrefetchL1Keep, pldl1keep
+RANDOM_READER_PREFETCH RandomReaderPrefetchL2Keep, pldl2keep
+RANDOM_READER_PREFETCH RandomReaderPrefetchL1Strm, pldl1strm
+
+## Writes prefetch for store, with the same target level and policy.
+RANDOM_WRITER_PREFETCH RandomWriterPrefetchL1Keep, pstl1keep
+RANDOM_WRITER_PREFETCH RandomWriterPrefetchL2Keep, pstl2keep
+RANDOM_WRITER_PREFETCH RandomWriterPrefetchL1Strm, pstl1strm
@@ -0,0 +1,398 @@
+#============================================================================
+# Scalable Vector Extension (SVE) routines for the cache benchmark.
+#
+# Copyright (C) 2024 Xuran Yang
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+# These are the vector-length-agnostic counterparts of WriterVector,
+# ReaderVector, RandomWriterVector, RandomReaderVector and memcpy_arm64.
+# Only call them when getauxval(AT_HWCAP) reports HWCAP_SVE.
+#=============================================================================
+
+.arch armv8.2-a+sve
+
+.global SVEVectorLength
+.global WriterSVE
+.global ReaderSVE
+.global RandomWriterSVE
+.global RandomReaderSVE
+.global memcpy_sve
+
+.global _SVEVectorLength
+.global _WriterSVE
+.global _ReaderSVE
+.global _RandomWriterSVE
+.global _RandomReaderSVE
+.global _memcpy_sve
+
+.text
+
+#-----------------------------------------------------------------------------
+# Name: 	SVEVectorLength
+# Purpose:	Returns the SVE vector length in bytes.
+#-----------------------------------------------------------------------------
+.align 4
+SVEVectorLength:
+_SVEVectorLength:
+	cntb	x0
+	ret
+
+#-----------------------------------------------------------------------------
+# Name: 	WriterSVE
+# Purpose:	Performs sequential write into memory, sixteen vectors (at
+#		least 256 bytes) per loop, the tail is written with a whilelo
+#		predicate.
+# Params:
+#	x0 = address
+#	x1 = length, multiple of 256
+#	x2 = count
+# 	x3 = value to write
+#-----------------------------------------------------------------------------
+.align 4
+WriterSVE:
+_WriterSVE:
+	ptrue	p0.b
+	dup	z0.d, x3
+	cntb	x6
+	lsl	x7, x6, 4
+
+.Lsw0:
+	mov	x4, x0
+	subs	x5, x1, x7
+	b.lo	.Lsw2
+
+.Lsw1:
+	addvl	x8, x4, 8
+	st1b	{z0.b}, p0, [x4]
+	st1b	{z0.b}, p0, [x4, 1, mul vl]
+	st1b	{z0.b}, p0, [x4, 2, mul vl]
+	st1b	{z0.b}, p0, [x4, 3, mul vl]
+	st1b	{z0.b}, p0, [x4, 4, mul vl]
+	st1b	{z0.b}, p0, [x4, 5, mul vl]
+	st1b	{z0.b}, p0, [x4, 6, mul vl]
+	st1b	{z0.b}, p0, [x4, 7, mul vl]
+	st1b	{z0.b}, p0, [x8]
+	st1b	{z0.b}, p0, [x8, 1, mul vl]
+	st1b	{z0.b}, p0, [x8, 2, mul vl]
+	st1b	{z0.b}, p0, [x8, 3, mul vl]
+	st1b	{z0.b}, p0, [x8, 4, mul vl]
+	st1b	{z0.b}, p0, [x8, 5, mul vl]
+	st1b	{z0.b}, p0, [x8, 6, mul vl]
+	st1b	{z0.b}, p0, [x8, 7, mul vl]
+	addvl	x4, x4, 16
+	subs	x5, x5, x7
+	b.hs	.Lsw1
+
+.Lsw2:
+	adds	x5, x5, x7
+	b.eq	.Lsw4
+
+.Lsw3:
+	whilelo	p1.b, xzr, x5
+	st1b	{z0.b}, p1, [x4]
+	addvl	x4, x4, 1
+	subs	x5, x5, x6
+	b.hi	.Lsw3
+
+.Lsw4:
+	subs	x2, x2, 1
+	bne	.Lsw0
+
+	dsb	st
+	ret
+
+#-----------------------------------------------------------------------------
+# Name: 	ReaderSVE
+# Purpose:	Performs sequential reads from memory, sixteen vectors (at
+#		least 256 bytes) per loop, the tail is read with a whilelo
+#		predicate.
+# Params:
+#	x0 = address
+#	x1 = length, multiple of 256
+#	x2 = count
+#-----------------------------------------------------------------------------
+.align 4
+ReaderSVE:
+_ReaderSVE:
+	ptrue	p0.b
+	cntb	x6
+	lsl	x7, x6, 4
+
+.Lsr0:
+	mov	x4, x0
+	subs	x5, x1, x7
+	b.lo	.Lsr2
+
+.Lsr1:
+	addvl	x8, x4, 8
+	ld1b	{z0.b}, p0/z, [x4]
+	ld1b	{z1.b}, p0/z, [x4, 1, mul vl]
+	ld1b	{z2.b}, p0/z, [x4, 2, mul vl]
+	ld1b	{z3.b}, p0/z, [x4, 3, mul vl]
+	ld1b	{z4.b}, p0/z, [x4, 4, mul vl]
+	ld1b	{z5.b}, p0/z, [x4, 5, mul vl]
+	ld1b	{z6.b}, p0/z, [x4, 6, mul vl]
+	ld1b	{z7.b}, p0/z, [x4, 7, mul vl]
+	ld1b	{z16.b}, p0/z, [x8]
+	ld1b	{z17.b}, p0/z, [x8, 1, mul vl]
+	ld1b	{z18.b}, p0/z, [x8, 2, mul vl]
+	ld1b	{z19.b}, p0/z, [x8, 3, mul vl]
+	ld1b	{z20.b}, p0/z, [x8, 4, mul vl]
+	ld1b	{z21.b}, p0/z, [x8, 5, mul vl]
+	ld1b	{z22.b}, p0/z, [x8, 6, mul vl]
+	ld1b	{z23.b}, p0/z, [x8, 7, mul vl]
+	addvl	x4, x4, 16
+	subs	x5, x5, x7
+	b.hs	.Lsr1
+
+.Lsr2:
+	adds	x5, x5, x7
+	b.eq	.Lsr4
+
+.Lsr3:
+	whilelo	p1.b, xzr, x5
+	ld1b	{z0.b}, p1/z, [x4]
+	addvl	x4, x4, 1
+	subs	x5, x5, x6
+	b.hi	.Lsr3
+
+.Lsr4:
+	subs	x2, x2, 1
+	bne	.Lsr0
+
+	dsb	ld
+	ret
+
+#-----------------------------------------------------------------------------
+# Chunk predicates for the random kernels: p<k> covers bytes k * VL to
+# (k + 1) * VL of a 256-byte chunk, so only the last vector is partial when
+# 256 is not a multiple of the vector length. Slot 0 is always whole and
+# slots 8 to 15 are only reached with 128-bit vectors, they all use p0.
+# x10 is set to the entry into the unrolled accesses that touches exactly
+# ceil(256 / VL) vectors, they are listed from slot 15 down to slot 0 and
+# addressed from x9 = chunk + 8 * VL.
+#-----------------------------------------------------------------------------
+.macro	CHUNK_PREDICATES end
+	cntb	x6
+	mov	x7, 256
+	ptrue	p0.b
+	mov	x8, x6
+	whilelo	p1.b, x8, x7
+	incb	x8
+	whilelo	p2.b, x8, x7
+	incb	x8
+	whilelo	p3.b, x8, x7
+	incb	x8
+	whilelo	p4.b, x8, x7
+	incb	x8
+	whilelo	p5.b, x8, x7
+	incb	x8
+	whilelo	p6.b, x8, x7
+	incb	x8
+	whilelo	p7.b, x8, x7
+	add	x8, x7, x6
+	sub	x8, x8, 1
+	udiv	x8, x8, x6
+	adr	x10, \end
+	sub	x10, x10, x8, lsl 2
+.endm
+
+#-----------------------------------------------------------------------------
+# Name: 	RandomWriterSVE
+# Purpose:	Performs random write into memory, one 256-byte chunk per
+#		pointer, written with fully unrolled predicated stores.
+# Params:
+# 	x0 = pointer to array of chunk pointers
+# 	x1 = # of 256-byte chunks
+# 	x2 = # loops to do
+# 	x3 = value to write
+#-----------------------------------------------------------------------------
+.align 4
+RandomWriterSVE:
+_RandomWriterSVE:
+	dup	z0.d, x3
+	CHUNK_PREDICATES .Lsrw2
+	adr	x12, .Lsrw3
+
+.Lsrw0:
+	mov	x5, -1
+	b	.Lsrw2
+
+.Lsrw1:
+	st1b	{z0.b}, p0, [x9, 7, mul vl]
+	st1b	{z0.b}, p0, [x9, 6, mul vl]
+	st1b	{z0.b}, p0, [x9, 5, mul vl]
+	st1b	{z0.b}, p0, [x9, 4, mul vl]
+	st1b	{z0.b}, p0, [x9, 3, mul vl]
+	st1b	{z0.b}, p0, [x9, 2, mul vl]
+	st1b	{z0.b}, p0, [x9, 1, mul vl]
+	st1b	{z0.b}, p0, [x9]
+	st1b	{z0.b}, p7, [x9, -1, mul vl]
+	st1b	{z0.b}, p6, [x9, -2, mul vl]
+	st1b	{z0.b}, p5, [x9, -3, mul vl]
+	st1b	{z0.b}, p4, [x9, -4, mul vl]
+	st1b	{z0.b}, p3, [x9, -5, mul vl]
+	st1b	{z0.b}, p2, [x9, -6, mul vl]
+	st1b	{z0.b}, p1, [x9, -7, mul vl]
+	st1b	{z0.b}, p0, [x9, -8, mul vl]
+
+.Lsrw2:
+	## Get pointer to the next chunk, the single branch leaves the loop
+	## after the last one. The index is kept in bounds for that final load.
+	add	x5, x5, 1
+	cmp	x5, x1
+	csel	x13, x10, x12, lo
+	csel	x14, x5, xzr, lo
+	ldr	x4, [x0, x14, lsl 3]
+	addvl	x9, x4, 8
+	br	x13
+
+.Lsrw3:
+	subs	x2, x2, 1
+	bne	.Lsrw0
+
+	dsb	st
+	ret
+
+#-----------------------------------------------------------------------------
+# Name: 	RandomReaderSVE
+# Purpose:	Performs random reads from memory, one 256-byte chunk per
+#		pointer, read with fully unrolled predicated loads.
+# Params:
+# 	x0 = pointer to array of chunk pointers
+# 	x1 = # of 256-byte chunks
+# 	x2 = # loops to do
+#-----------------------------------------------------------------------------
+.align 4
+RandomReaderSVE:
+_RandomReaderSVE:
+	CHUNK_PREDICATES .Lsrr2
+	adr	x12, .Lsrr3
+
+.Lsrr0:
+	mov	x5, -1
+	b	.Lsrr2
+
+.Lsrr1:
+	ld1b	{z31.b}, p0/z, [x9, 7, mul vl]
+	ld1b	{z30.b}, p0/z, [x9, 6, mul vl]
+	ld1b	{z29.b}, p0/z, [x9, 5, mul vl]
+	ld1b	{z28.b}, p0/z, [x9, 4, mul vl]
+	ld1b	{z27.b}, p0/z, [x9, 3, mul vl]
+	ld1b	{z26.b}, p0/z, [x9, 2, mul vl]
+	ld1b	{z25.b}, p0/z, [x9, 1, mul vl]
+	ld1b	{z24.b}, p0/z, [x9]
+	ld1b	{z23.b}, p7/z, [x9, -1, mul vl]
+	ld1b	{z22.b}, p6/z, [x9, -2, mul vl]
+	ld1b	{z21.b}, p5/z, [x9, -3, mul vl]
+	ld1b	{z20.b}, p4/z, [x9, -4, mul vl]
+	ld1b	{z19.b}, p3/z, [x9, -5, mul vl]
+	ld1b	{z18.b}, p2/z, [x9, -6, mul vl]
+	ld1b	{z17.b}, p1/z, [x9, -7, mul vl]
+	ld1b	{z16.b}, p0/z, [x9, -8, mul vl]
+
+.Lsrr2:
+	## Get pointer to the next chunk, the single branch leaves the loop
+	## after the last one. The index is kept in bounds for that final load.
+	add	x5, x5, 1
+	cmp	x5, x1
+	csel	x13, x10, x12, lo
+	csel	x14, x5, xzr, lo
+	ldr	x4, [x0, x14, lsl 3]
+	addvl	x9, x4, 8
+	br	x13
+
+.Lsrr3:
+	subs	x2, x2, 1
+	bne	.Lsrr0
+
+	dsb	ld
+	ret
+
+#-----------------------------------------------------------------------------
+# Name: 	memcpy_sve
+# Purpose:	Copies memory sixteen vectors (at least 256 bytes) per loop,
+#		the tail is copied with a whilelo predicate.
+# Params:
+#	x0 = destination
+#	x1 = source
+#	x2 = length in bytes
+#-----------------------------------------------------------------------------
+.align 4
+memcpy_sve:
+_memcpy_sve:
+	ptrue	p0.b
+	cntb	x6
+	lsl	x7, x6, 4
+	mov	x4, x1
+	mov	x5, x0
+	subs	x3, x2, x7
+	b.lo	.Lsc1
+
+.Lsc0:
+	addvl	x8, x4, 8
+	addvl	x9, x5, 8
+	ld1b	{z0.b}, p0/z, [x4]
+	ld1b	{z1.b}, p0/z, [x4, 1, mul vl]
+	ld1b	{z2.b}, p0/z, [x4, 2, mul vl]
+	ld1b	{z3.b}, p0/z, [x4, 3, mul vl]
+	ld1b	{z4.b}, p0/z, [x4, 4, mul vl]
+	ld1b	{z5.b}, p0/z, [x4, 5, mul vl]
+	ld1b	{z6.b}, p0/z, [x4, 6, mul vl]
+	ld1b	{z7.b}, p0/z, [x4, 7, mul vl]
+	ld1b	{z16.b}, p0/z, [x8]
+	ld1b	{z17.b}, p0/z, [x8, 1, mul vl]
+	ld1b	{z18.b}, p0/z, [x8, 2, mul vl]
+	ld1b	{z19.b}, p0/z, [x8, 3, mul vl]
+	ld1b	{z20.b}, p0/z, [x8, 4, mul vl]
+	ld1b	{z21.b}, p0/z, [x8, 5, mul vl]
+	ld1b	{z22.b}, p0/z, [x8, 6, mul vl]
+	ld1b	{z23.b}, p0/z, [x8, 7, mul vl]
+	st1b	{z0.b}, p0, [x5]
+	st1b	{z1.b}, p0, [x5, 1, mul vl]
+	st1b	{z2.b}, p0, [x5, 2, mul vl]
+	st1b	{z3.b}, p0, [x5, 3, mul vl]
+	st1b	{z4.b}, p0, [x5, 4, mul vl]
+	st1b	{z5.b}, p0, [x5, 5, mul vl]
+	st1b	{z6.b}, p0, [x5, 6, mul vl]
+	st1b	{z7.b}, p0, [x5, 7, mul vl]
+	st1b	{z16.b}, p0, [x9]
+	st1b	{z17.b}, p0, [x9, 1, mul vl]
+	st1b	{z18.b}, p0, [x9, 2, mul vl]
+	st1b	{z19.b}, p0, [x9, 3, mul vl]
+	st1b	{z20.b}, p0, [x9, 4, mul vl]
+	st1b	{z21.b}, p0, [x9, 5, mul vl]
+	st1b	{z22.b}, p0, [x9, 6, mul vl]
+	st1b	{z23.b}, p0, [x9, 7, mul vl]
+	addvl	x4, x4, 16
+	addvl	x5, x5, 16
+	subs	x3, x3, x7
+	b.hs	.Lsc0
+
+.Lsc1:
+	adds	x3, x3, x7
+	b.eq	.Lsc3
+
+.Lsc2:
+	whilelo	p1.b, xzr, x3
+	ld1b	{z0.b}, p1/z, [x4]
+	st1b	{z0.b}, p1, [x5]
+	addvl	x4, x4, 1
+	addvl	x5, x5, 1
+	subs	x3, x3, x6
+	b.hi	.Lsc2
+
+.Lsc3:
+	ret
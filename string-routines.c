@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2024 Xuran Yang
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <omp.h>
+
+#include "string-routines.h"
+
+extern void *memset_arm64(void *s, int c, size_t n);
+extern void *memmove_arm64(void *dest, const void *src, size_t n);
+extern int memcmp_arm64(const void *s1, const void *s2, size_t n);
+extern void *memchr_arm64(const void *s, int c, size_t n);
+extern size_t strlen_arm64(const char *s);
+extern void *memset_sve(void *s, int c, size_t n);
+extern void *memmove_sve(void *dest, const void *src, size_t n);
+extern int memcmp_sve(const void *s1, const void *s2, size_t n);
+extern void *memchr_sve(const void *s, int c, size_t n);
+extern size_t strlen_sve(const char *s);
+
+char *string_routine_name[] = { "memset", "memmove", "memcmp", "memchr", "strlen", 0 };
+
+/* Keep GCC from turning the byte loops back into libc calls or vector loops. */
+#define NAIVE                                                                       \
+	__attribute__((noinline, optimize("no-tree-loop-distribute-patterns",       \
+					  "no-tree-vectorize", "no-tree-slp-vectorize")))
+
+NAIVE static void *naive_memset(void *s, int c, size_t n)
+{
+	unsigned char *p = s;
+
+	for (size_t i = 0; i < n; i++)
+		p[i] = c;
+	return s;
+}
+
+NAIVE static void *naive_memmove(void *dest, const void *src, size_t n)
+{
+	unsigned char *d = dest;
+	const unsigned char *s = src;
+
+	if (d < s) {
+		for (size_t i = 0; i < n; i++)
+			d[i] = s[i];
+	} else {
+		for (size_t i = n; i > 0; i--)
+			d[i - 1] = s[i - 1];
+	}
+	return dest;
+}
+
+NAIVE static int naive_memcmp(const void *s1, const void *s2, size_t n)
+{
+	const unsigned char *a = s1, *b = s2;
+
+	for (size_t i = 0; i < n; i++) {
+		if (a[i] != b[i])
+			return a[i] - b[i];
+	}
+	return 0;
+}
+
+NAIVE static void *naive_memchr(const void *s, int c, size_t n)
+{
+	const unsigned char *p = s;
+
+	for (size_t i = 0; i < n; i++) {
+		if (p[i] == (unsigned char)c)
+			return (void *)(p + i);
+	}
+	return NULL;
+}
+
+NAIVE static size_t naive_strlen(const char *s)
+{
+	size_t i = 0;
+
+	while (s[i])
+		i++;
+	return i;
+}
+
+struct string_impl {
+	void *(*set)(void *, int, size_t);
+	void *(*move)(void *, const void *, size_t);
+	int (*cmp)(const void *, const void *, size_t);
+	void *(*chr)(const void *, int, size_t);
+	size_t (*len)(const char *);
+};
+
+/* Not const, so the compiler cannot see through the calls and inline them. */
+struct string_impl string_impls[IMPL_MAX] = {
+	{ memset, memmove, memcmp, memchr, strlen },
+	{ memset_arm64, memmove_arm64, memcmp_arm64, memchr_arm64, strlen_arm64 },
+	{ naive_memset, naive_memmove, naive_memcmp, naive_memchr, naive_strlen },
+	{ memset_sve, memmove_sve, memcmp_sve, memchr_sve, strlen_sve },
+};
+
+volatile uint64_t string_sink;
+
+static int sign(int x)
+{
+	return (x > 0) - (x < 0);
+}
+
+/*
+ * Compare the first @impls implementations against glibc for small sizes, all
+ * 16-byte misalignments and every match position. Returns the number of
+ * mismatches.
+ */
+int string_check(int impls)
+{
+	unsigned char *a = aligned_alloc(4096, 8192), *b = aligned_alloc(4096, 8192);
+	unsigned char *c = aligned_alloc(4096, 8192);
+	int errors = 0;
+
+	for (int impl = IMPL_ARM64; impl < impls; impl++) {
+		struct string_impl *f = &string_impls[impl];
+
+		for (size_t n = 0; n <= 300; n++) {
+			for (int off = 0; off < 16; off++) {
+				size_t pos = n ? (n * 7 + off) % n : 0;
+
+				for (int i = 0; i < 8192; i++)
+					a[i] = b[i] = c[i] = 'a' + (i * 13) % 23;
+
+				f->set(a + off, 0x5a, n);
+				memset(b + off, 0x5a, n);
+				errors += memcmp(a, b, 8192) != 0;
+
+				f->move(a + off + n / 3, a + off, n);
+				memmove(b + off + n / 3, b + off, n);
+				f->move(a + off, a + off + n / 2, n);
+				memmove(b + off, b + off + n / 2, n);
+				errors += memcmp(a, b, 8192) != 0;
+
+				memcpy(c + off, b + off, n);
+				errors += sign(f->cmp(b + off, c + off, n)) != 0;
+				if (n) {
+					c[off + pos] ^= 0x80;
+					errors += sign(f->cmp(b + off, c + off, n)) !=
+						  sign(memcmp(b + off, c + off, n));
+					errors += sign(f->cmp(c + off, b + off, n)) !=
+						  sign(memcmp(c + off, b + off, n));
+				}
+
+				memset(a + off, 'a', n + 64);
+				if (n)
+					a[off + pos] = 'x';
+				a[off + n + 1] = 'x';
+				errors += f->chr(a + off, 'x', n) != memchr(a + off, 'x', n);
+
+				a[off + n] = 0;
+				errors += f->len((char *)a + off) != strlen((char *)a + off);
+			}
+		}
+	}
+
+	free(a);
+	free(b);
+	free(c);
+	return errors;
+}
+
+/*
+ * Run @routine from @impl on @threads threads. Each thread owns @region bytes
+ * of @buf: the first half is the primary buffer, the second half the memcmp
+ * peer, both misaligned by @offset. The match (memcmp difference, memchr hit,
+ * strlen terminator) is placed at byte @pos of the @size bytes, and memmove
+ * shifts the buffer onto itself by half its size. Buffers are prepared outside
+ * the timed loop.
+ */
+void string_performance_test(int routine, int impl, void *buf, uint64_t region, uint64_t size,
+			     uint64_t pos, int offset, int threads, uint64_t iter, double *rate,
+			     double *latency)
+{
+	struct string_impl *f = &string_impls[impl];
+	double start, end;
+
+#pragma omp parallel for schedule(static)
+	for (int job = 0; job < threads; job++) {
+		char *a = (char *)buf + region * job + offset;
+		char *b = a + region / 2;
+
+		memset(a, 'a', size);
+		memset(b, 'a', size);
+		if (routine == STR_MEMCMP)
+			b[pos] = 'b';
+		if (routine == STR_MEMCHR)
+			a[pos] = 'x';
+		if (routine == STR_STRLEN)
+			a[pos] = 0;
+	}
+
+	start = omp_get_wtime();
+#pragma omp parallel for schedule(static)
+	for (int job = 0; job < threads; job++) {
+		char *a = (char *)buf + region * job + offset;
+		char *b = a + region / 2;
+		uint64_t sum = 0;
+
+		switch (routine) {
+		case STR_MEMSET:
+			for (uint64_t i = 0; i < iter; i++)
+				f->set(a, i, size);
+			break;
+		case STR_MEMMOVE:
+			for (uint64_t i = 0; i < iter; i++)
+				f->move(a + (size + 1) / 2, a, size);
+			break;
+		case STR_MEMCMP:
+			for (uint64_t i = 0; i < iter; i++)
+				sum += f->cmp(a, b, size);
+			break;
+		case STR_MEMCHR:
+			for (uint64_t i = 0; i < iter; i++)
+				sum += (uintptr_t)f->chr(a, 'x', size);
+			break;
+		case STR_STRLEN:
+			for (uint64_t i = 0; i < iter; i++)
+				sum += f->len(a);
+			break;
+		}
+#pragma omp atomic
+		string_sink += sum;
+	}
+	end = omp_get_wtime();
+
+	*rate = (double)size * iter * threads / 1024 / 1024 / (end - start);
+	*latency = (end - start) * 1e9 / iter;
+}
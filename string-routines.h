@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2024 Xuran Yang
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef STRING_ROUTINES_H
+#define STRING_ROUTINES_H
+
+#include <stdint.h>
+
+enum {
+	STR_MEMSET = 0,
+	STR_MEMMOVE = 1,
+	STR_MEMCMP = 2,
+	STR_MEMCHR = 3,
+	STR_STRLEN = 4,
+	STR_MAX
+};
+/* IMPL_SVE is last, so runs without SVE stop at IMPL_SVE. */
+enum { IMPL_GLIBC = 0, IMPL_ARM64 = 1, IMPL_NAIVE = 2, IMPL_SVE = 3, IMPL_MAX };
+
+extern char *string_routine_name[];
+
+int string_check(int impls);
+void string_performance_test(int routine, int impl, void *buf, uint64_t region, uint64_t size,
+			     uint64_t pos, int offset, int threads, uint64_t iter, double *rate,
+			     double *latency);
+
+#endif
@@ -0,0 +1,274 @@
+#============================================================================
+# Scalable Vector Extension (SVE) string routines.
+#
+# Copyright (C) 2024 Xuran Yang
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+# Vector-length-agnostic counterparts of the routines in string-arm64.S.
+# Only call them when getauxval(AT_HWCAP) reports HWCAP_SVE.
+#=============================================================================
+
+.arch armv8.2-a+sve
+
+.global memset_sve
+.global memmove_sve
+.global memcmp_sve
+.global memchr_sve
+.global strlen_sve
+
+.global _memset_sve
+.global _memmove_sve
+.global _memcmp_sve
+.global _memchr_sve
+.global _strlen_sve
+
+.text
+
+#-----------------------------------------------------------------------------
+# Name: 	memset_sve
+# Purpose:	Sets memory four vectors per loop, the last 0..4 vectors are
+#		set straight-line with whilelo predicates.
+# Params:
+#	x0 = destination
+#	w1 = value
+#	x2 = length in bytes
+#-----------------------------------------------------------------------------
+.align 4
+memset_sve:
+_memset_sve:
+	dup	z0.b, w1
+	ptrue	p0.b
+	cntb	x6
+	lsl	x7, x6, 2
+	mov	x4, x0
+	subs	x3, x2, x7
+	b.lo	.Lms1
+
+.Lms0:
+	st1b	{z0.b}, p0, [x4]
+	st1b	{z0.b}, p0, [x4, 1, mul vl]
+	st1b	{z0.b}, p0, [x4, 2, mul vl]
+	st1b	{z0.b}, p0, [x4, 3, mul vl]
+	add	x4, x4, x7
+	subs	x3, x3, x7
+	b.hs	.Lms0
+
+.Lms1:
+	add	x3, x3, x7
+	add	x5, x6, x6
+	add	x8, x5, x6
+	whilelo	p1.b, xzr, x3
+	whilelo	p2.b, x6, x3
+	whilelo	p3.b, x5, x3
+	whilelo	p4.b, x8, x3
+	st1b	{z0.b}, p1, [x4]
+	st1b	{z0.b}, p2, [x4, 1, mul vl]
+	st1b	{z0.b}, p3, [x4, 2, mul vl]
+	st1b	{z0.b}, p4, [x4, 3, mul vl]
+	ret
+
+#-----------------------------------------------------------------------------
+# Name: 	memmove_sve
+# Purpose:	Copies possibly overlapping memory four vectors per loop,
+#		backwards if the destination starts inside the source. Every
+#		step loads all of its vectors before storing any of them.
+# Params:
+#	x0 = destination
+#	x1 = source
+#	x2 = length in bytes
+#-----------------------------------------------------------------------------
+.align 4
+memmove_sve:
+_memmove_sve:
+	ptrue	p0.b
+	cntb	x6
+	lsl	x7, x6, 2
+	sub	x3, x0, x1
+	cmp	x3, x2
+	b.lo	.Lmm2
+
+	mov	x4, x1
+	mov	x5, x0
+	subs	x3, x2, x7
+	b.lo	.Lmm4
+
+.Lmm1:
+	ld1b	{z0.b}, p0/z, [x4]
+	ld1b	{z1.b}, p0/z, [x4, 1, mul vl]
+	ld1b	{z2.b}, p0/z, [x4, 2, mul vl]
+	ld1b	{z3.b}, p0/z, [x4, 3, mul vl]
+	st1b	{z0.b}, p0, [x5]
+	st1b	{z1.b}, p0, [x5, 1, mul vl]
+	st1b	{z2.b}, p0, [x5, 2, mul vl]
+	st1b	{z3.b}, p0, [x5, 3, mul vl]
+	add	x4, x4, x7
+	add	x5, x5, x7
+	subs	x3, x3, x7
+	b.hs	.Lmm1
+	b	.Lmm4
+
+	## Backwards from the end, the first 0..4 vectors are left for the tail.
+.Lmm2:
+	add	x4, x1, x2
+	add	x5, x0, x2
+	subs	x3, x2, x7
+	b.lo	.Lmm3
+
+.Lmm2l:
+	sub	x4, x4, x7
+	sub	x5, x5, x7
+	ld1b	{z0.b}, p0/z, [x4]
+	ld1b	{z1.b}, p0/z, [x4, 1, mul vl]
+	ld1b	{z2.b}, p0/z, [x4, 2, mul vl]
+	ld1b	{z3.b}, p0/z, [x4, 3, mul vl]
+	st1b	{z0.b}, p0, [x5]
+	st1b	{z1.b}, p0, [x5, 1, mul vl]
+	st1b	{z2.b}, p0, [x5, 2, mul vl]
+	st1b	{z3.b}, p0, [x5, 3, mul vl]
+	subs	x3, x3, x7
+	b.hs	.Lmm2l
+
+.Lmm3:
+	mov	x4, x1
+	mov	x5, x0
+
+	## Copy the remaining 0..4 vectors at x4 to x5.
+.Lmm4:
+	add	x3, x3, x7
+	add	x9, x6, x6
+	add	x8, x9, x6
+	whilelo	p1.b, xzr, x3
+	whilelo	p2.b, x6, x3
+	whilelo	p3.b, x9, x3
+	whilelo	p4.b, x8, x3
+	ld1b	{z0.b}, p1/z, [x4]
+	ld1b	{z1.b}, p2/z, [x4, 1, mul vl]
+	ld1b	{z2.b}, p3/z, [x4, 2, mul vl]
+	ld1b	{z3.b}, p4/z, [x4, 3, mul vl]
+	st1b	{z0.b}, p1, [x5]
+	st1b	{z1.b}, p2, [x5, 1, mul vl]
+	st1b	{z2.b}, p3, [x5, 2, mul vl]
+	st1b	{z3.b}, p4, [x5, 3, mul vl]
+	ret
+
+#-----------------------------------------------------------------------------
+# Name: 	memcmp_sve
+# Purpose:	Compares memory one vector per step, returns the difference of
+#		the first mismatching bytes.
+# Params:
+#	x0 = first buffer
+#	x1 = second buffer
+#	x2 = length in bytes
+#-----------------------------------------------------------------------------
+.align 4
+memcmp_sve:
+_memcmp_sve:
+	mov	x3, xzr
+	whilelo	p0.b, xzr, x2
+	b.none	.Lmc2
+
+.Lmc0:
+	ld1b	{z0.b}, p0/z, [x0, x3]
+	ld1b	{z1.b}, p0/z, [x1, x3]
+	cmpne	p1.b, p0/z, z0.b, z1.b
+	b.any	.Lmc1
+	incb	x3
+	whilelo	p0.b, x3, x2
+	b.first	.Lmc0
+	b	.Lmc2
+
+	## The first mismatch is the element after the last one before the break.
+.Lmc1:
+	brkb	p1.b, p0/z, p1.b
+	lasta	w0, p1, z0.b
+	lasta	w1, p1, z1.b
+	sub	w0, w0, w1
+	ret
+
+.Lmc2:
+	mov	x0, xzr
+	ret
+
+#-----------------------------------------------------------------------------
+# Name: 	memchr_sve
+# Purpose:	Finds the first byte equal to w1, one vector per step.
+# Params:
+#	x0 = buffer
+#	w1 = byte to find
+#	x2 = length in bytes
+#-----------------------------------------------------------------------------
+.align 4
+memchr_sve:
+_memchr_sve:
+	dup	z1.b, w1
+	mov	x3, xzr
+	whilelo	p0.b, xzr, x2
+	b.none	.Lmr2
+
+.Lmr0:
+	ld1b	{z0.b}, p0/z, [x0, x3]
+	cmpeq	p1.b, p0/z, z0.b, z1.b
+	b.any	.Lmr1
+	incb	x3
+	whilelo	p0.b, x3, x2
+	b.first	.Lmr0
+	b	.Lmr2
+
+.Lmr1:
+	brkb	p1.b, p0/z, p1.b
+	incp	x3, p1.b
+	add	x0, x0, x3
+	ret
+
+.Lmr2:
+	mov	x0, xzr
+	ret
+
+#-----------------------------------------------------------------------------
+# Name: 	strlen_sve
+# Purpose:	Returns the length of a NUL-terminated string. First-fault
+#		loads stop at an unmapped page, the faulting lanes are
+#		retried as the first lane of the next step.
+# Params:
+#	x0 = string
+#-----------------------------------------------------------------------------
+.align 4
+strlen_sve:
+_strlen_sve:
+	ptrue	p2.b
+	mov	x1, xzr
+
+.Lsl0:
+	setffr
+	ldff1b	{z0.b}, p2/z, [x0, x1]
+	rdffrs	p0.b, p2/z
+	b.nlast	.Lsl1
+	cmpeq	p1.b, p2/z, z0.b, 0
+	b.any	.Lsl2
+	incb	x1
+	b	.Lsl0
+
+	## Only the lanes in p0 were loaded.
+.Lsl1:
+	cmpeq	p1.b, p0/z, z0.b, 0
+	b.any	.Lsl2
+	incp	x1, p0.b
+	b	.Lsl0
+
+.Lsl2:
+	brkb	p1.b, p2/z, p1.b
+	incp	x1, p1.b
+	mov	x0, x1
+	ret